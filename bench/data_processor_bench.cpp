@@ -0,0 +1,413 @@
+#include "data_processor.h"
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// Benchmarks for the DataProcessor hot paths. Sizes and worker counts are
+// benchmark arguments, so results from different releases line up by name:
+//
+//   data_processor_bench --benchmark_out=bench.json --benchmark_out_format=json
+//
+// Arguments are bytes for buffer operations, rows or files for database and
+// directory benchmarks, and the worker pool size where a second one is given.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// One processor per worker pool size, shared by every benchmark that asks
+// for it so setup cost stays out of the timed loops.
+DataProcessor& processorFor(std::size_t workers) {
+    static std::mutex mutex;
+    static std::map<std::size_t, std::unique_ptr<DataProcessor>> processors;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = processors[workers];
+    if (!slot) {
+        DataProcessorOptions options;
+        options.workerThreads = workers;
+        options.collectStats = false;
+        slot = std::make_unique<DataProcessor>(options);
+        slot->setLogLevel(spdlog::level::off);
+    }
+    return *slot;
+}
+
+// Deterministic printable payload; compresses roughly like log text
+std::string makePayload(std::size_t size) {
+    static const char* words[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot",
+                                  "golf", "hotel", "india", "juliet", "kilo", "lima"};
+    std::mt19937 rng(42);
+    std::string out;
+    out.reserve(size + 16);
+    while (out.size() < size) {
+        out += words[rng() % 12];
+        out += (rng() % 8 == 0) ? '\n' : ' ';
+    }
+    out.resize(size);
+    return out;
+}
+
+std::string makeJsonDocument(std::size_t size) {
+    std::string out = "{\"records\": [";
+    for (std::size_t i = 0; out.size() < size; ++i) {
+        out += fmt::format(R"({}{{"id": {}, "name": "user_{}", "score": {}.5, "tags": ["a", "b"]}})",
+                           i == 0 ? "" : ", ", i, i, i % 100);
+    }
+    out += "]}";
+    return out;
+}
+
+std::string makeNdjson(std::size_t size) {
+    std::string out;
+    for (std::size_t i = 0; out.size() < size; ++i) {
+        out += fmt::format(R"({{"id": {}, "user": {{"name": "user_{}", "age": {}}}, "active": {}}})",
+                           i, i, 20 + i % 50, i % 2 == 0 ? "true" : "false");
+        out += '\n';
+    }
+    return out;
+}
+
+fs::path scratchPath(const std::string& name) {
+    return fs::temp_directory_path() / fmt::format("dp_bench_{}_{}", name, ::getpid());
+}
+
+void setBytes(benchmark::State& state, std::size_t bytesPerIteration) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytesPerIteration));
+}
+
+// --- JSON -----------------------------------------------------------------
+
+void BM_JsonParse(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string doc = makeJsonDocument(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.processJsonData(doc));
+    }
+    setBytes(state, doc.size());
+}
+BENCHMARK(BM_JsonParse)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+void BM_JsonLines(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makeNdjson(static_cast<std::size_t>(state.range(0)));
+    const std::vector<std::string> fields = {"id", "user.name"};
+    std::int64_t sum = 0;
+    for (auto _ : state) {
+        processor.processJsonLines(data, fields, [&](std::size_t, const std::vector<JsonField>& f) {
+            sum += f[0].integer;
+            return true;
+        });
+    }
+    benchmark::DoNotOptimize(sum);
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_JsonLines)->RangeMultiplier(8)->Range(1 << 16, 1 << 24);
+
+void BM_JsonBatch(benchmark::State& state) {
+    auto& processor = processorFor(static_cast<std::size_t>(state.range(1)));
+    const std::string data = makeNdjson(static_cast<std::size_t>(state.range(0)));
+    const std::vector<std::string> fields = {"id", "user.name"};
+    std::atomic<std::int64_t> sum{0};
+    for (auto _ : state) {
+        processor.processJsonBatch(data, fields, [&](std::size_t, const std::vector<JsonField>& f) {
+            sum.fetch_add(f[0].integer, std::memory_order_relaxed);
+            return true;
+        });
+    }
+    benchmark::DoNotOptimize(sum.load());
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_JsonBatch)->ArgsProduct({{1 << 20, 1 << 24}, {1, 2, 4, 8}})->UseRealTime();
+
+// --- Hashing and encryption -----------------------------------------------
+
+void BM_Hash(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makePayload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.generateHash(data));
+    }
+    setBytes(state, data.size());
+}
+// Several callers share one processor, as request handlers would
+BENCHMARK(BM_Hash)->RangeMultiplier(16)->Range(64, 1 << 20)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_HashBatch(benchmark::State& state) {
+    auto& processor = processorFor(static_cast<std::size_t>(state.range(1)));
+    std::vector<std::string> inputs(static_cast<std::size_t>(state.range(0)), makePayload(4096));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.generateHashes(inputs));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * inputs.size()));
+    setBytes(state, inputs.size() * 4096);
+}
+BENCHMARK(BM_HashBatch)->ArgsProduct({{64, 4096}, {1, 2, 4, 8}})->UseRealTime();
+
+void BM_Encrypt(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makePayload(static_cast<std::size_t>(state.range(0)));
+    const std::string key(32, 'k');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.encryptData(data, key));
+    }
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_Encrypt)->RangeMultiplier(16)->Range(64, 1 << 20)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_Decrypt(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makePayload(static_cast<std::size_t>(state.range(0)));
+    const std::string key(32, 'k');
+    const std::string sealed = processor.encryptData(data, key);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.decryptData(sealed, key));
+    }
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_Decrypt)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+// --- Compression ----------------------------------------------------------
+
+void BM_Compress(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makePayload(static_cast<std::size_t>(state.range(0)));
+    std::string out;
+    for (auto _ : state) {
+        processor.compress(data, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["ratio"] = out.empty() ? 0.0 : static_cast<double>(data.size()) / out.size();
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_Compress)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+void BM_Decompress(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string data = makePayload(static_cast<std::size_t>(state.range(0)));
+    std::string packed;
+    processor.compress(data, packed);
+    std::string out;
+    for (auto _ : state) {
+        processor.decompress(packed, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    setBytes(state, data.size());
+}
+BENCHMARK(BM_Decompress)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+void BM_CompressFile(benchmark::State& state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    auto& processor = processorFor(static_cast<std::size_t>(state.range(1)));
+    const fs::path input = scratchPath("compress_in");
+    const fs::path output = scratchPath("compress_out");
+    {
+        std::ofstream file(input, std::ios::binary);
+        const std::string data = makePayload(size);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    CompressionOptions options;
+    options.parallel = state.range(1) > 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.compressFile(input.string(), output.string(), options));
+    }
+    setBytes(state, size);
+    fs::remove(input);
+    fs::remove(output);
+}
+BENCHMARK(BM_CompressFile)->ArgsProduct({{1 << 24, 1 << 26}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// --- Regex ----------------------------------------------------------------
+
+// Every iteration uses a pattern the cache has not seen, so each call pays
+// for compilation
+void BM_RegexCold(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string text = makePayload(static_cast<std::size_t>(state.range(0)));
+    std::uint64_t counter = 0;
+    for (auto _ : state) {
+        const std::string pattern = fmt::format(R"((delta|echo)\s+\w+{})", counter++);
+        benchmark::DoNotOptimize(processor.processTextWithRegex(text, pattern));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_RegexCold)->RangeMultiplier(16)->Range(256, 1 << 20);
+
+void BM_RegexCached(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string text = makePayload(static_cast<std::size_t>(state.range(0)));
+    const std::string pattern = R"((delta|echo)\s+\w+z)";
+    processor.precompilePatterns({pattern});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.processTextWithRegex(text, pattern));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_RegexCached)->RangeMultiplier(16)->Range(256, 1 << 20)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_RegexPatternSet(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    const std::string text = makePayload(1 << 16);
+    std::vector<std::string> patterns;
+    for (int i = 0; i < state.range(0); ++i) {
+        patterns.push_back(fmt::format(R"(\w+{}\w*)", i));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.scanWithPatternSet(text, patterns));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_RegexPatternSet)->RangeMultiplier(4)->Range(1, 256);
+
+// --- Database -------------------------------------------------------------
+
+// Created by initializeDatabase
+const std::string kLogTable = "data_processor_logs";
+
+struct DatabaseFixture {
+    explicit DatabaseFixture(const DatabaseOptions& options)
+        : path(scratchPath("db")) {
+        // Separate processor: the database connection is per instance
+        DataProcessorOptions processorOptions;
+        processorOptions.collectStats = false;
+        processor = std::make_unique<DataProcessor>(processorOptions);
+        processor->setLogLevel(spdlog::level::off);
+        processor->initializeDatabase(path.string(), options);
+    }
+    ~DatabaseFixture() {
+        processor.reset();
+        for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+            fs::remove(path.string() + suffix);
+        }
+    }
+
+    fs::path path;
+    std::unique_ptr<DataProcessor> processor;
+};
+
+DatabaseOptions databaseOptions(std::int64_t mode) {
+    DatabaseOptions options;
+    options.walMode = mode >= 1;
+    options.synchronousNormal = mode >= 1;
+    options.backgroundWriter = mode >= 2;
+    return options;
+}
+
+// Mode 0 is the default rollback journal, 1 is WAL with synchronous=NORMAL,
+// 2 adds the background group-commit writer
+void BM_StoreSingle(benchmark::State& state) {
+    DatabaseFixture db(databaseOptions(state.range(1)));
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const std::string row = makePayload(128);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < rows; ++i) {
+            db.processor->storeData(kLogTable, row);
+        }
+        db.processor->flushWrites();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * rows));
+}
+BENCHMARK(BM_StoreSingle)->ArgsProduct({{100, 1000}, {0, 1, 2}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_StoreBatch(benchmark::State& state) {
+    DatabaseFixture db(databaseOptions(state.range(1)));
+    const std::vector<std::string> rows(static_cast<std::size_t>(state.range(0)), makePayload(128));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(db.processor->storeBatch(kLogTable, rows));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * rows.size()));
+}
+BENCHMARK(BM_StoreBatch)->ArgsProduct({{100, 1000, 10000}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// --- Directory scan -------------------------------------------------------
+
+class DirectoryFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State& state) override {
+        root = scratchPath("scan");
+        const auto files = static_cast<std::size_t>(state.range(0));
+        for (std::size_t i = 0; i < files; ++i) {
+            const fs::path dir = root / fmt::format("d{:03}", i / 100);
+            fs::create_directories(dir);
+            std::ofstream(dir / fmt::format("f{}.txt", i)) << "bench file " << i << '\n';
+        }
+    }
+    void TearDown(const benchmark::State&) override {
+        fs::remove_all(root);
+    }
+
+    fs::path root;
+};
+
+BENCHMARK_DEFINE_F(DirectoryFixture, ProcessFiles)(benchmark::State& state) {
+    auto& processor = processorFor(0);
+    std::size_t seen = 0;
+    for (auto _ : state) {
+        processor.processFilesInDirectory(root.string(), [&](const std::string&) { ++seen; });
+    }
+    benchmark::DoNotOptimize(seen);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(DirectoryFixture, ProcessFiles)->RangeMultiplier(10)->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(DirectoryFixture, IndexDirectory)(benchmark::State& state) {
+    DatabaseOptions options = databaseOptions(1);
+    options.fileIndex = true;
+    DatabaseFixture db(options);
+    IndexScanResult result;
+    for (auto _ : state) {
+        // After the first pass this measures the incremental (unchanged) path
+        db.processor->indexDirectory(root.string(), result);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(DirectoryFixture, IndexDirectory)->RangeMultiplier(10)->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(DirectoryFixture, RunBatch)(benchmark::State& state) {
+    DatabaseOptions options = databaseOptions(1);
+    options.fileIndex = true;
+    DatabaseFixture db(options);
+    CipherSession session(std::string(CipherSession::kKeySize, 'k'));
+    BatchJob job;
+    job.inputDirectory = root.string();
+    job.outputDirectory = scratchPath("batch").string();
+    job.session = &session;
+    BatchReport report;
+    for (auto _ : state) {
+        report = db.processor->runBatch(job);
+    }
+    // Busy seconds per stage show which one bounds the pipeline
+    for (const BatchStageStats& stage : report.stages) {
+        state.counters[stage.name + "_busy_s"] = stage.busySeconds;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    fs::remove_all(job.outputDirectory);
+}
+BENCHMARK_REGISTER_F(DirectoryFixture, RunBatch)->RangeMultiplier(10)->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::AddCustomContext("hardware_concurrency", std::to_string(std::thread::hardware_concurrency()));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -4,6 +4,13 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <array>
+#include <future>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
 
 // Forward declarations to avoid including all headers
 namespace spdlog {
@@ -61,6 +68,490 @@ namespace OpenSSL {
     struct EVP_CIPHER_CTX;
 }
 
+/**
+ * @brief AES-256-GCM bound to one 32-byte key
+ *
+ * Operations run on per-thread cipher contexts that keep this session's
+ * expanded key, so repeated calls only reset the nonce. A session is
+ * immutable once built and may be shared across threads.
+ *
+ * seal() output is nonce | ciphertext | tag. For large payloads the chunk
+ * calls seal each chunk independently (so chunks can be processed in
+ * parallel) under a nonce derived from a per-stream nonce and the chunk
+ * index; the final chunk is marked, so reordering and truncation fail
+ * authentication. Sealed chunks are plaintext size + kTagSize bytes.
+ */
+class CipherSession {
+public:
+    static constexpr std::size_t kKeySize = 32;
+    static constexpr std::size_t kNonceSize = 12;
+    static constexpr std::size_t kTagSize = 16;
+    using Nonce = std::array<unsigned char, kNonceSize>;
+
+    explicit CipherSession(const std::string& key);
+    ~CipherSession();
+    CipherSession(const CipherSession&) = delete;
+    CipherSession& operator=(const CipherSession&) = delete;
+
+    // False when the key is not exactly kKeySize bytes
+    bool ok() const { return ok_; }
+
+    static std::size_t sealedSize(std::size_t plaintextSize) { return plaintextSize + kNonceSize + kTagSize; }
+    static bool newNonce(Nonce& nonce);
+
+    bool seal(std::string_view plaintext, char* output, std::size_t capacity, std::size_t& written) const;
+    bool open(std::string_view sealed, char* output, std::size_t capacity, std::size_t& written) const;
+
+    bool sealChunk(const Nonce& streamNonce, std::uint64_t index, bool last,
+                   std::string_view plaintext, char* output) const;
+    bool openChunk(const Nonce& streamNonce, std::uint64_t index, bool last,
+                   std::string_view sealed, char* output) const;
+
+private:
+    static Nonce chunkNonce(const Nonce& streamNonce, std::uint64_t index);
+    bool crypt(bool encrypt, const Nonce& nonce, unsigned char flag, std::string_view input,
+               unsigned char* output, unsigned char* tag) const;
+
+    std::array<unsigned char, kKeySize> key_{};
+    std::uint64_t id_;
+    bool ok_ = false;
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * The mapping is advised for sequential access. Hashing, compressing,
+ * scanning and parsing one MappedBuffer all read the same page-cache pages
+ * without copying them into private buffers. view() stays valid for the
+ * buffer's lifetime; an empty file maps to an empty view.
+ */
+class MappedBuffer {
+public:
+    MappedBuffer();
+    explicit MappedBuffer(const std::string& path);
+    ~MappedBuffer();
+    MappedBuffer(MappedBuffer&& other) noexcept;
+    MappedBuffer& operator=(MappedBuffer&& other) noexcept;
+    MappedBuffer(const MappedBuffer&) = delete;
+    MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+    // False when the file is missing or can't be mapped (pipes, devices)
+    bool ok() const { return ok_; }
+    std::string_view view() const { return {data_, size_}; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    struct Region;
+    std::unique_ptr<Region> region_;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool ok_ = false;
+};
+
+/**
+ * @brief Settings for the shared HTTP client behind the network operations
+ */
+struct HttpOptions {
+    // Transfers running at once; further requests wait their turn
+    std::size_t maxConcurrentTransfers = 16;
+    // Connections per host; 0 leaves it to libcurl. With HTTP/2 requests
+    // to one host share a connection as multiplexed streams.
+    std::size_t maxHostConnections = 0;
+    // Negotiate HTTP/2 over TLS, falling back to HTTP/1.1
+    bool http2 = true;
+    // Whole-transfer timeout in seconds
+    long timeoutSeconds = 30;
+};
+
+/**
+ * @brief Resume and segmentation settings for DataProcessor::downloadFile
+ */
+struct DownloadOptions {
+    // Continue an existing partial localPath with a Range request; restarts
+    // from scratch if the server ignores the range
+    bool resume = false;
+    // Fetch the file as up to this many concurrent byte ranges when the
+    // server reports a length; falls back to one transfer if ranges fail
+    std::size_t segments = 1;
+    // Smallest range worth a separate request
+    std::size_t minSegmentSize = 4 << 20;
+};
+
+/**
+ * @brief Outcome of one HTTP transfer
+ */
+struct HttpResponse {
+    // False on any transport error or an HTTP status of 400 or above
+    bool ok = false;
+    // Last HTTP status received; 0 for non-HTTP URLs or when none arrived
+    long status = 0;
+    // Declared body length; -1 when the server did not send one
+    std::int64_t contentLength = -1;
+    // Response body; empty for downloads written to a file or sink
+    std::string body;
+    std::string error;
+};
+
+/**
+ * @brief Logger setup for DataProcessor
+ */
+struct LoggingOptions {
+    // Format and write records on a background thread; callers only enqueue
+    bool async = true;
+    // Records the async ring buffer holds. Processors asking for the same
+    // size share one ring and log thread.
+    std::size_t queueSize = 8192;
+    // When the ring is full, overwrite the oldest record instead of blocking
+    bool dropOnOverflow = true;
+    // Runtime threshold as a spdlog::level value (0 trace ... 6 off). Per-call
+    // success messages are trace and compiled out unless SPDLOG_ACTIVE_LEVEL
+    // is lowered to SPDLOG_LEVEL_TRACE.
+    int level = 2;
+};
+
+/**
+ * @brief Optional subsystems, combined into DataProcessorOptions::features
+ *
+ * Each library is set up once per process the first time an enabled
+ * processor uses it. Calls into a disabled subsystem fail with an error.
+ */
+enum class Feature : std::uint32_t {
+    None = 0,
+    // libcurl transfers: downloads, makeHttpRequest, fetchAsync
+    Network = 1u << 0,
+    // FreeType/HarfBuzz text rendering and layout
+    Text = 1u << 1,
+    All = 0xffffffffu
+};
+
+constexpr Feature operator|(Feature a, Feature b) {
+    return static_cast<Feature>(static_cast<std::uint32_t>(a) | static_cast<std::uint32_t>(b));
+}
+
+constexpr bool hasFeature(Feature mask, Feature feature) {
+    return (static_cast<std::uint32_t>(mask) & static_cast<std::uint32_t>(feature)) != 0;
+}
+
+/**
+ * @brief Construction-time settings for DataProcessor
+ */
+struct DataProcessorOptions {
+    // Worker pool size; 0 selects std::thread::hardware_concurrency()
+    std::size_t workerThreads = 0;
+    // Tasks allowed to wait in the pool before submitters block
+    std::size_t maxQueuedTasks = 1024;
+    // Compiled regex patterns kept before the least recently used is evicted
+    std::size_t regexCacheCapacity = 256;
+    // Shaped text runs (text, font, size) kept for renderText/processTextLayout
+    std::size_t shapeCacheCapacity = 1024;
+    HttpOptions http;
+    // Keep per-operation counts and latency histograms for generateJsonReport.
+    // When off, instrumented calls skip even the clock reads; the report's
+    // processed_items and errors totals are kept either way.
+    bool collectStats = true;
+    LoggingOptions logging;
+    // Subsystems this processor may use
+    Feature features = Feature::All;
+};
+
+/**
+ * @brief Counters reported by DataProcessor::regexCacheStats
+ */
+struct RegexCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t entries = 0;
+};
+
+/**
+ * @brief Size and margins for DataProcessor::renderText and processTextLayout
+ */
+struct TextOptions {
+    int pixelSize = 32;
+    // Blank border around the rendered line, in pixels
+    int padding = 4;
+};
+
+/**
+ * @brief Measured extent of one shaped line of text
+ */
+struct TextLayout {
+    // Pixel size of the image renderText would produce, padding included
+    int width = 0;
+    int height = 0;
+    std::size_t glyphs = 0;
+};
+
+/**
+ * @brief Counters reported by DataProcessor::textCacheStats
+ */
+struct TextCacheStats {
+    std::size_t faces = 0;
+    // Shaped-run LRU
+    std::uint64_t shapeHits = 0;
+    std::uint64_t shapeMisses = 0;
+    // Glyph atlas lookups across all faces; a miss rasterizes the glyph
+    std::uint64_t glyphHits = 0;
+    std::uint64_t glyphMisses = 0;
+    std::size_t atlasPages = 0;
+};
+
+/**
+ * @brief Connection settings applied by DataProcessor::initializeDatabase
+ */
+struct DatabaseOptions {
+    // Use write-ahead logging instead of the rollback journal
+    bool walMode = false;
+    // PRAGMA synchronous=NORMAL; with WAL this only syncs at checkpoints
+    bool synchronousNormal = false;
+    // Queue storeData rows for a writer thread that commits them in groups
+    bool backgroundWriter = false;
+    // Upper bound on rows per background transaction
+    std::size_t writerBatchSize = 4096;
+    // Rows storeData may queue for the writer; past this it blocks
+    std::size_t writerQueueLimit = 65536;
+    // Create the file_index table used by DataProcessor::indexDirectory
+    bool fileIndex = false;
+    // Read-only connections that serve queryData alongside the writer.
+    // Requires walMode and a file database; 0 runs queries on the writer.
+    std::size_t readConnections = 0;
+};
+
+/**
+ * @brief Outcome of one DataProcessor::indexDirectory pass
+ */
+struct IndexScanResult {
+    std::size_t files = 0;
+    std::size_t added = 0;
+    std::size_t changed = 0;
+    std::size_t removed = 0;
+    std::size_t unchanged = 0;
+};
+
+/**
+ * @brief One DataProcessor::runBatch job: archive a directory tree and index it
+ *
+ * Each regular file under inputDirectory goes through scan, read, hash,
+ * compress, encrypt and store stages. Store writes outputDirectory/<relative
+ * path> plus ".z" (zlib), or ".sealed" when a session is set, and records
+ * the file's SHA-256 in file_index (see DatabaseOptions::fileIndex).
+ */
+struct BatchJob {
+    std::string inputDirectory;
+    // Created if missing; skipped by the scan if it lies inside inputDirectory
+    std::string outputDirectory;
+    // Seals each compressed file with CipherSession::seal; null writes plain zlib
+    const CipherSession* session = nullptr;
+    // zlib level 0-9; -1 selects zlib's default
+    int level = -1;
+    // Files each queue between two stages holds before the upstream stage waits
+    std::size_t queueCapacity = 64;
+    // Record each file in file_index; needs an initialized database
+    bool storeIndex = true;
+};
+
+/**
+ * @brief Counters for one stage of a DataProcessor::runBatch pipeline
+ *
+ * The stage limiting a job is the one that rarely waits: its input queue
+ * is deep and its waits are short, while the stages around it wait on it.
+ */
+struct BatchStageStats {
+    std::string name;
+    std::uint64_t items = 0;
+    // Input bytes of the files that passed through
+    std::uint64_t bytes = 0;
+    // Time spent working, summed over workers; hash, compress and encrypt
+    // fan out over the worker pool
+    double busySeconds = 0.0;
+    // Waiting for the upstream stage (input queue empty)
+    double inputWaitSeconds = 0.0;
+    // Waiting for the downstream stage (output queue full)
+    double outputWaitSeconds = 0.0;
+    // Depth of this stage's input queue, sampled on every push
+    std::size_t maxQueueDepth = 0;
+    double meanQueueDepth = 0.0;
+};
+
+/**
+ * @brief Outcome of DataProcessor::runBatch, also kept for generateJsonReport
+ */
+struct BatchReport {
+    bool ok = false;
+    std::size_t files = 0;
+    std::size_t failed = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    double seconds = 0.0;
+    // scan, read, hash, compress, encrypt, store, in pipeline order
+    std::vector<BatchStageStats> stages;
+    std::string firstError;
+};
+
+/**
+ * @brief Settings for the gzip overload of DataProcessor::compressFile and
+ * for sealed archives
+ */
+struct CompressionOptions {
+    // zlib level 0-9; -1 selects zlib's default
+    int level = -1;
+    // Input bytes per independently deflated block (at least 32 KiB)
+    std::size_t blockSize = 1 << 20;
+    // Deflate blocks on the worker pool instead of the calling thread
+    bool parallel = true;
+};
+
+/**
+ * @brief Tuning for DataProcessor::queryData cursors
+ */
+struct QueryOptions {
+    // Rows stepped per hold of the writer connection's lock; writers can
+    // interleave between pages of a long-running query. Queries served by
+    // a read connection hold it throughout.
+    std::size_t pageSize = 256;
+};
+
+enum class ImageFormat { Unknown, Png, Jpeg };
+
+/**
+ * @brief Dimensions and layout of a decoded image
+ */
+struct ImageInfo {
+    ImageFormat format = ImageFormat::Unknown;
+    int width = 0;
+    int height = 0;
+    // 1 gray, 2 gray+alpha, 3 RGB, 4 RGBA
+    int channels = 0;
+};
+
+/**
+ * @brief Output settings for DataProcessor::convertImageFormat
+ */
+struct ImageOptions {
+    // Target format; Unknown picks it from the output extension (.png,
+    // .jpg, .jpeg), falling back to the input's format
+    ImageFormat format = ImageFormat::Unknown;
+    // Shrink so the longer edge is at most this many pixels; 0 keeps the
+    // size. Images are never enlarged.
+    int maxDimension = 0;
+    // JPEG quality, 1-100
+    int quality = 85;
+};
+
+/**
+ * @brief Outcome of one image conversion
+ */
+struct ImageResult {
+    bool ok = false;
+    // What was written
+    ImageInfo output;
+    std::string error;
+};
+
+/**
+ * @brief Location of one regex match within the scanned text
+ */
+struct MatchSpan {
+    std::size_t patternIndex = 0;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+};
+
+enum class JsonType { Missing, Null, Boolean, Integer, Float, String, Container };
+
+/**
+ * @brief One requested field of a streamed JSON record
+ *
+ * Only the member matching type is meaningful. Objects and arrays found at
+ * a requested path are reported as Container without their contents.
+ */
+struct JsonField {
+    JsonType type = JsonType::Missing;
+    bool boolean = false;
+    // Integer values; number holds every numeric value as a double
+    std::int64_t integer = 0;
+    double number = 0.0;
+    // String values, unescaped
+    std::string text;
+};
+
+/**
+ * @brief Counts from one NDJSON pass
+ */
+struct JsonStreamResult {
+    std::size_t records = 0;
+    // Malformed lines, skipped
+    std::size_t errors = 0;
+};
+
+struct sqlite3_stmt;
+struct evp_md_ctx_st;
+
+using Sha256Digest = std::array<unsigned char, 32>;
+using Sha256Hex = std::array<char, 64>;
+
+/**
+ * @brief Incremental SHA-256 for inputs too large to hold in memory
+ *
+ * Feed chunks with update(); finalize() writes the digest and resets the
+ * hasher so the same context can be reused for the next input.
+ */
+class Hasher {
+public:
+    Hasher();
+    ~Hasher();
+    Hasher(Hasher&& other) noexcept;
+    Hasher& operator=(Hasher&& other) noexcept;
+    Hasher(const Hasher&) = delete;
+    Hasher& operator=(const Hasher&) = delete;
+
+    bool update(std::string_view data);
+    bool finalize(Sha256Digest& digest);
+    void reset();
+
+    // Lowercase hex, as returned by DataProcessor::generateHash
+    static Sha256Hex toHex(const Sha256Digest& digest);
+
+private:
+    evp_md_ctx_st* ctx_;
+    bool ok_ = false;
+};
+
+/**
+ * @brief Current row of a queryData cursor
+ *
+ * Column views point into SQLite's buffers and stay valid only until the
+ * visitor returns; copy anything that must outlive the call.
+ */
+class QueryRow {
+public:
+    int columnCount() const;
+    std::string_view columnName(int index) const;
+    std::string_view column(int index) const;
+    std::int64_t columnInt(int index) const;
+    bool isNull(int index) const;
+
+private:
+    friend class DataProcessor;
+    explicit QueryRow(sqlite3_stmt* stmt) : stmt_(stmt) {}
+    sqlite3_stmt* stmt_;
+};
+
+// Receives output in order, one chunk at a time; return false to abort
+using ChunkSink = std::function<bool(std::string_view chunk)>;
+
+// Called once per regular file, concurrently from pool threads
+using FileVisitor = std::function<void(const std::string& path)>;
+
+// Receives the requested fields in request order with the record's
+// 1-based line number. The fields are reused for the next record; copy
+// what must be kept. Return false to stop.
+using JsonRecordVisitor = std::function<bool(std::size_t line, const std::vector<JsonField>& fields)>;
+
+// Return false to stop iteration early
+using RowVisitor = std::function<bool(const QueryRow&)>;
+
 /**
  * @brief Complex data processor that demonstrates deep transitive dependencies
  * 
@@ -75,50 +566,199 @@ namespace OpenSSL {
  * - curl -> HTTP operations
  * - libpng/libjpeg-turbo -> image processing
  * - freetype/harfbuzz -> font rendering
+ *
+ * One instance may be shared by any number of threads. Compiled regexes and
+ * configuration are shared; digest, cipher and zlib contexts are per thread,
+ * and transfers run on a shared multi handle.
  */
 class DataProcessor {
 public:
     DataProcessor();
+    explicit DataProcessor(const DataProcessorOptions& options);
     ~DataProcessor();
 
     // JSON Processing
-    bool processJsonData(const std::string& jsonData);
+    bool processJsonData(std::string_view jsonData);
     std::string generateJsonReport() const;
+    // NDJSON streaming: one JSON value per line, each parsed in place with
+    // the SAX parser and reduced to the requested fields, so memory stays
+    // constant however large the input. Fields are dot-separated object
+    // key paths ("user.id"). Blank lines are skipped; malformed lines are
+    // counted and skipped, and make the call return false.
+    bool processJsonLines(std::string_view data, const std::vector<std::string>& fields, const JsonRecordVisitor& visitor);
+    bool processJsonLines(std::string_view data, const std::vector<std::string>& fields,
+                          const JsonRecordVisitor& visitor, JsonStreamResult& result);
+    // Parallel NDJSON: the input is split at newline boundaries and the
+    // pieces are parsed on the worker pool, so the visitor runs concurrently
+    // and records arrive out of order, each with its true line number. The
+    // file overload parses straight from a memory mapping.
+    bool processJsonBatch(std::string_view data, const std::vector<std::string>& fields, const JsonRecordVisitor& visitor);
+    bool processJsonBatch(std::string_view data, const std::vector<std::string>& fields,
+                          const JsonRecordVisitor& visitor, JsonStreamResult& result);
+    bool processJsonBatchFile(const std::string& path, const std::vector<std::string>& fields, const JsonRecordVisitor& visitor);
+    bool processJsonBatchFile(const std::string& path, const std::vector<std::string>& fields,
+                              const JsonRecordVisitor& visitor, JsonStreamResult& result);
+    bool processJsonFile(const std::string& path, const std::vector<std::string>& fields, const JsonRecordVisitor& visitor);
+    bool processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                         const JsonRecordVisitor& visitor, JsonStreamResult& result);
+    // Reads a file in another charset (e.g. "UTF-16LE"), converted to UTF-8 as it streams
+    bool processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                         const JsonRecordVisitor& visitor, JsonStreamResult& result, const std::string& encoding);
     
     // File System Operations
     bool processFilesInDirectory(const std::string& directoryPath);
+    // Walks the tree in parallel, one pool task per subdirectory
+    bool processFilesInDirectory(const std::string& directoryPath, const FileVisitor& visitor);
+    // Brings file_index up to date for the tree: new or resized/touched
+    // files are hashed, vanished ones dropped, the rest only stat'ed.
+    // The mtime column holds nanoseconds since the epoch.
+    // Requires DatabaseOptions::fileIndex.
+    bool indexDirectory(const std::string& directoryPath);
+    bool indexDirectory(const std::string& directoryPath, IndexScanResult& result);
     bool compressFile(const std::string& inputPath, const std::string& outputPath);
+    // Writes a single-member gzip file, deflating blocks in parallel. Blocks
+    // are read straight from a mapping of the input when it can be mapped.
+    bool compressFile(const std::string& inputPath, const std::string& outputPath, const CompressionOptions& options);
+    bool compressFile(const MappedBuffer& input, const std::string& outputPath,
+                      const CompressionOptions& options = CompressionOptions{});
+    // Detects gzip, zlib or bzip2 input from its magic bytes
     bool decompressFile(const std::string& inputPath, const std::string& outputPath);
+    bool decompressFile(const std::string& inputPath, const ChunkSink& sink);
+    // Sealed archives: deflate blocks sealed as AES-256-GCM chunks in one
+    // streaming pass with bounded memory; blocks are processed on the pool
+    // unless options.parallel is false. Opening fails on a wrong key or any
+    // corrupted, reordered or truncated record.
+    bool compressEncryptFile(const std::string& inputPath, const std::string& outputPath,
+                             const CipherSession& session, const CompressionOptions& options = CompressionOptions{});
+    bool decryptDecompressFile(const std::string& inputPath, const std::string& outputPath, const CipherSession& session);
+    bool decryptDecompressFile(const std::string& inputPath, const CipherSession& session, const ChunkSink& sink);
+    // Runs a BatchJob end to end. The stages run concurrently, connected
+    // by bounded queues, so a slow stage holds back the ones before it
+    // instead of letting files pile up in memory. Failed files are counted
+    // and skipped. The latest report appears under "batch" in
+    // generateJsonReport.
+    BatchReport runBatch(const BatchJob& job);
+    
+    // In-memory compression (zlib format) on per-thread reusable streams.
+    // The buffer overloads write at most capacity bytes and fail if the
+    // result does not fit; the string overloads reuse output's capacity.
+    std::size_t maxCompressedSize(std::size_t inputSize) const;
+    bool compress(std::string_view input, char* output, std::size_t capacity, std::size_t& written, int level = -1);
+    bool compress(std::string_view input, std::string& output, int level = -1);
+    bool decompress(std::string_view input, char* output, std::size_t capacity, std::size_t& written);
+    bool decompress(std::string_view input, std::string& output);
     
     // Database Operations
     bool initializeDatabase(const std::string& dbPath);
+    bool initializeDatabase(const std::string& dbPath, const DatabaseOptions& options);
     bool storeData(const std::string& table, const std::string& data);
+    // Inserts all rows in a single transaction
+    bool storeBatch(const std::string& table, const std::vector<std::string>& rows);
+    // Blocks until the background writer has drained its queue. False if any
+    // row queued since the previous flush failed to commit; the failure is
+    // also logged and kept as the last error.
+    bool flushWrites();
+    // Materializes every row as '|'-separated columns; prefer the cursor overload for large results
     std::vector<std::string> queryData(const std::string& query);
+    // Streams rows to the visitor with params bound as text to ?1..?N. The
+    // visitor runs with the connection locked and must not call back into
+    // the database methods.
+    bool queryData(const std::string& query, const std::vector<std::string>& params,
+                   const RowVisitor& visitor, const QueryOptions& options = QueryOptions{});
     
     // Network Operations
     bool downloadFile(const std::string& url, const std::string& localPath);
+    // Streams the body to the sink as it arrives, with no intermediate file or buffer
+    bool downloadFile(const std::string& url, const ChunkSink& sink);
+    bool downloadFile(const std::string& url, const std::string& localPath, const DownloadOptions& options);
+    // Writes the response body as a sealed archive (see compressEncryptFile)
+    bool downloadFile(const std::string& url, const std::string& localPath,
+                      const CipherSession& session, const CompressionOptions& options = CompressionOptions{});
+    // Downloads (url, localPath) pairs concurrently; results are in input order
+    std::vector<HttpResponse> downloadFiles(const std::vector<std::pair<std::string, std::string>>& transfers);
+    // Body of a GET request; empty on failure
     std::string makeHttpRequest(const std::string& url);
+    std::future<HttpResponse> fetchAsync(const std::string& url);
+    
+    // Charset Conversion
+    // Encoding names are those iconv accepts ("ISO-8859-1", "UTF-16LE").
+    // Descriptors are cached per thread and (from, to) pair. Pure 7-bit
+    // input between ASCII-compatible charsets is copied without iconv.
+    // Invalid or unconvertible input fails rather than being replaced.
+    bool convertEncoding(std::string_view input, const std::string& fromEncoding, const std::string& toEncoding,
+                         std::string& output);
+    // Streams the file through the converter in chunks
+    bool convertEncodingFile(const std::string& inputPath, const std::string& outputPath,
+                             const std::string& fromEncoding, const std::string& toEncoding);
+    bool convertEncodingFile(const std::string& inputPath, const std::string& fromEncoding,
+                             const std::string& toEncoding, const ChunkSink& sink);
     
     // Image Processing
+    // PNG and JPEG are decoded a row at a time, so no full bitmap is held;
+    // JPEG downscaling starts in the DCT domain. Alpha is flattened onto
+    // white when writing JPEG.
+    // Decodes the whole image to validate it
     bool processImage(const std::string& imagePath);
+    bool processImage(const std::string& imagePath, ImageInfo& info);
     bool convertImageFormat(const std::string& inputPath, const std::string& outputPath);
+    ImageResult convertImageFormat(const std::string& inputPath, const std::string& outputPath,
+                                   const ImageOptions& options);
+    // Converts (input, output) pairs on the worker pool; results are in input order
+    std::vector<ImageResult> convertImages(const std::vector<std::pair<std::string, std::string>>& jobs,
+                                           const ImageOptions& options = ImageOptions{});
     
     // Text Processing
-    bool processTextWithRegex(const std::string& text, const std::string& pattern);
-    std::vector<std::string> extractMatches(const std::string& text, const std::string& pattern);
+    // Text is taken as a view, so a MappedBuffer::view() is scanned in place
+    bool processTextWithRegex(std::string_view text, const std::string& pattern);
+    // Converts text from encoding to UTF-8 before matching
+    bool processTextWithRegex(std::string_view text, const std::string& pattern, const std::string& encoding);
+    // Match locations ordered by offset; slice text to read the matched bytes
+    std::vector<MatchSpan> extractMatches(std::string_view text, const std::string& pattern);
+    std::vector<MatchSpan> extractMatches(std::string_view text, const std::vector<std::string>& patterns);
+    // Indices of every pattern that matches anywhere in text, found in a single pass
+    std::vector<int> scanWithPatternSet(std::string_view text, const std::vector<std::string>& patterns);
+    // Compiles patterns into the regex cache ahead of use; returns how many are valid
+    std::size_t precompilePatterns(const std::vector<std::string>& patterns);
+    RegexCacheStats regexCacheStats() const;
     
     // Font Rendering
+    // renderText writes one line as an 8-bit grayscale PNG, black on white.
+    // Faces are opened once per path, shaped runs are cached by text, font
+    // and size, and glyph bitmaps are kept in a per-face atlas, so repeated
+    // labels are neither re-shaped nor re-rasterized.
     bool renderText(const std::string& text, const std::string& fontPath, const std::string& outputPath);
+    bool renderText(const std::string& text, const std::string& fontPath, const std::string& outputPath,
+                    const TextOptions& options);
     bool processTextLayout(const std::string& text, const std::string& fontPath);
+    bool processTextLayout(const std::string& text, const std::string& fontPath, const TextOptions& options,
+                           TextLayout& layout);
+    TextCacheStats textCacheStats() const;
     
     // Cryptography
+    // Legacy AES-256-CBC with a zero IV; prefer CipherSession for new data
     std::string encryptData(const std::string& data, const std::string& key);
     std::string decryptData(const std::string& encryptedData, const std::string& key);
     std::string generateHash(const std::string& data);
+    // Caller-buffer forms: output keeps its capacity across calls, so a
+    // reused buffer makes steady-state calls allocation-free
+    bool encryptData(std::string_view data, std::string_view key, std::string& output);
+    bool decryptData(std::string_view encryptedData, std::string_view key, std::string& output);
+    bool generateHash(std::string_view data, Sha256Hex& hex);
+    // Digests in input order, computed on one reused context; empty on failure
+    std::vector<Sha256Digest> generateHashes(const std::vector<std::string>& inputs);
+    // SHA-256 hex of a file's contents, read through a memory mapping
+    std::string hashFile(const std::string& path);
+    std::string hashFile(const MappedBuffer& file);
     
     // Threading and Async Operations
-    void processDataAsync(const std::string& data, std::function<void(const std::string&)> callback);
+    // A future of an operation dropped by cancelPending() throws std::future_error.
+    std::future<void> processDataAsync(const std::string& data, std::function<void(const std::string&)> callback);
+    // Moves data into the task instead of copying it
+    std::future<void> processDataAsync(std::string&& data, std::function<void(const std::string&)> callback);
     void waitForCompletion();
+    bool waitForCompletion(std::chrono::milliseconds timeout);
+    std::size_t cancelPending();
+    std::size_t pendingOperations() const;
     
     // Logging and Monitoring
     void setLogLevel(int level);
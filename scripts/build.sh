@@ -157,11 +157,11 @@ run_benchmarks() {
     if [ "$1" = "--benchmark" ]; then
         print_status "Running benchmarks..."
         
-        if [ -f "$BUILD_DIR/bin/benchmark_runner" ]; then
+        if [ -f "$BUILD_DIR/bin/data_processor_bench" ]; then
             cd "$BUILD_DIR/bin"
-            ./benchmark_runner
+            ./data_processor_bench --benchmark_out=benchmark_results.json --benchmark_out_format=json
             cd ../..
-            print_success "Benchmarks completed"
+            print_success "Benchmarks completed: $BUILD_DIR/bin/benchmark_results.json"
         else
             print_warning "Benchmark executable not found, skipping benchmarks"
         fi
@@ -318,7 +318,7 @@ main() {
     print_status "Executables:"
     print_status "  - Main app: $BUILD_DIR/bin/complex_app"
     print_status "  - Tests: $BUILD_DIR/bin/test_runner"
-    print_status "  - Benchmarks: $BUILD_DIR/bin/benchmark_runner"
+    print_status "  - Benchmarks: $BUILD_DIR/bin/data_processor_bench"
     print_status "  - gRPC example: $BUILD_DIR/bin/grpc_example"
     print_status "============================================="
 }
@@ -1,7 +1,14 @@
+// Per-call success messages use SPDLOG_LOGGER_TRACE, which compiles to
+// nothing unless the build lowers this to SPDLOG_LEVEL_TRACE
+#ifndef SPDLOG_ACTIVE_LEVEL
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#endif
+
 #include "data_processor.h"
 
 // Include all the complex dependencies
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <nlohmann/json.hpp>
 #include <boost/filesystem.hpp>
@@ -9,13 +16,17 @@
 #include <boost/thread.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/regex.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <openssl/ssl.h>
 #include <openssl/crypto.h>
 #include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <zlib.h>
 #include <bzlib.h>
 #include <iconv.h>
 #include <re2/re2.h>
+#include <re2/set.h>
 #include <sqlite3.h>
 #include <curl/curl.h>
 #include <png.h>
@@ -33,499 +44,6448 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <array>
+#include <tuple>
+#include <list>
+#include <map>
+#include <optional>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <limits>
+#include <climits>
+#include <cstring>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
+#include <sys/stat.h>
 
 using json = nlohmann::json;
 namespace fs = boost::filesystem;
 namespace pt = boost::posix_time;
 
-// PIMPL implementation
-class DataProcessor::Impl {
+namespace {
+
+// Every processor writes through one console sink. Loggers are per
+// processor and unregistered, so each keeps its own level and any number
+// can coexist.
+std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> sharedConsoleSink() {
+    static const auto sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    return sink;
+}
+
+// libcurl's global state, initialized by the first processor to make a
+// transfer and released at exit. Processors are gone by then, and their
+// handles with them.
+bool curlGlobal() {
+    struct CurlGlobal {
+        CurlGlobal() : ok(curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK) {}
+        ~CurlGlobal() {
+            if (ok) {
+                curl_global_cleanup();
+            }
+        }
+        bool ok;
+    };
+    static const CurlGlobal global;
+    return global.ok;
+}
+
+// Process-wide FreeType library, created on first use. FT_Library is not
+// thread-safe; hold the returned mutex while creating faces or rendering.
+struct FreeTypeLibrary {
+    FT_Library library = nullptr;
+    std::mutex mutex;
+};
+
+FreeTypeLibrary* freeTypeLibrary() {
+    struct Holder {
+        Holder() {
+            if (FT_Init_FreeType(&state.library) != 0) {
+                state.library = nullptr;
+            }
+        }
+        ~Holder() {
+            if (state.library) {
+                FT_Done_FreeType(state.library);
+            }
+        }
+        FreeTypeLibrary state;
+    };
+    static Holder holder;
+    return holder.state.library ? &holder.state : nullptr;
+}
+
+// One background log thread per ring size, shared by every async logger
+// that asks for that size. Each is kept until exit so short-lived
+// processors don't each spawn and join one.
+std::shared_ptr<spdlog::details::thread_pool> sharedLogPool(std::size_t queueSize) {
+    static std::mutex mutex;
+    static std::map<std::size_t, std::shared_ptr<spdlog::details::thread_pool>> pools;
+    queueSize = std::max<std::size_t>(queueSize, 1);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[queueSize];
+    if (!pool) {
+        pool = std::make_shared<spdlog::details::thread_pool>(queueSize, 1);
+    }
+    return pool;
+}
+
+// Fixed-size executor with one task deque per worker, started on first use.
+// Workers pop their own deque LIFO and steal FIFO from the others; tasks
+// submitted from a worker land on that worker's deque so nested fan-out
+// stays local. External submitters block once maxQueued tasks are waiting.
+class WorkerPool {
 public:
-    Impl() : logger_(nullptr), db_(nullptr), curl_(nullptr), 
-             ft_library_(nullptr), ft_face_(nullptr), hb_font_(nullptr) {
-        initializeComponents();
+    WorkerPool(std::size_t threadCount, std::size_t maxQueued)
+        : maxQueued_(maxQueued == 0 ? 1 : maxQueued) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        workAvailable_.notify_all();
+        spaceAvailable_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        std::future<Result> future = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // Blocks until no task is queued or running.
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this]() { return queued_ == 0 && running_ == 0; });
+    }
+
+    std::size_t threadCount() const { return queues_.size(); }
+
+    bool onWorkerThread() const { return currentPool_ == this; }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void enqueue(std::function<void()> task) {
+        const bool fromWorker = currentPool_ == this;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Workers never block on the bound: a task waiting on its own
+            // children would otherwise deadlock a full pool.
+            if (!fromWorker) {
+                spaceAvailable_.wait(lock, [this]() { return queued_ < maxQueued_ || stopping_; });
+            }
+            if (stopping_) {
+                throw std::runtime_error("WorkerPool is shutting down");
+            }
+            // Threads start with the first task, so processors that never
+            // touch the pool don't pay for spawning them
+            if (threads_.empty()) {
+                for (std::size_t i = 0; i < queues_.size(); ++i) {
+                    threads_.emplace_back([this, i]() { workerLoop(i); });
+                }
+            }
+            std::size_t target = fromWorker ? currentIndex_ : nextQueue_++ % queues_.size();
+            {
+                std::lock_guard<std::mutex> queueLock(queues_[target]->mutex);
+                queues_[target]->tasks.push_back(std::move(task));
+            }
+            ++queued_;
+        }
+        workAvailable_.notify_one();
+    }
+
+    bool tryPop(std::size_t index, std::function<void()>& task) {
+        {
+            WorkerQueue& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+            WorkerQueue& victim = *queues_[(index + offset) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(std::size_t index) {
+        currentPool_ = this;
+        currentIndex_ = index;
+        std::function<void()> task;
+        while (true) {
+            if (tryPop(index, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --queued_;
+                    ++running_;
+                }
+                spaceAvailable_.notify_one();
+                task();
+                task = nullptr;
+                bool idle;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --running_;
+                    idle = queued_ == 0 && running_ == 0;
+                }
+                if (idle) {
+                    idle_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stopping_ && queued_ == 0) {
+                return;
+            }
+            // queued_ can briefly exceed what is visible in the deques while
+            // another worker is between its pop and the decrement; yield
+            // instead of sleeping in that window.
+            if (queued_ > 0) {
+                lock.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+            workAvailable_.wait(lock, [this]() { return queued_ > 0 || stopping_; });
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable spaceAvailable_;
+    std::condition_variable idle_;
+    std::size_t maxQueued_;
+    std::size_t queued_ = 0;
+    std::size_t running_ = 0;
+    std::size_t nextQueue_ = 0;
+    bool stopping_ = false;
+
+    static thread_local WorkerPool* currentPool_;
+    static thread_local std::size_t currentIndex_;
+};
+
+thread_local WorkerPool* WorkerPool::currentPool_ = nullptr;
+thread_local std::size_t WorkerPool::currentIndex_ = 0;
+
+// SHA-256 method fetched once; under OpenSSL 3 going through EVP_sha256()
+// repeats the provider lookup on every digest init.
+const EVP_MD* sha256Method() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static const EVP_MD* method = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return method;
+#else
+    return EVP_sha256();
+#endif
+}
+
+// One digest context per thread, re-initialized per input
+bool hashOnThreadContext(std::string_view data, Sha256Digest& digest) {
+    thread_local std::unique_ptr<EVP_MD_CTX, void (*)(EVP_MD_CTX*)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    unsigned int length = 0;
+    return ctx && EVP_DigestInit_ex(ctx.get(), sha256Method(), nullptr) == 1 &&
+           EVP_DigestUpdate(ctx.get(), data.data(), data.size()) == 1 &&
+           EVP_DigestFinal_ex(ctx.get(), digest.data(), &length) == 1 &&
+           length == digest.size();
+}
+
+const EVP_CIPHER* aes256GcmMethod() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static const EVP_CIPHER* method = EVP_CIPHER_fetch(nullptr, "AES-256-GCM", nullptr);
+    return method;
+#else
+    return EVP_aes_256_gcm();
+#endif
+}
+
+// Per-thread GCM contexts. Each remembers which CipherSession last keyed
+// it, so repeated operations with one session only reset the nonce and
+// keep the expanded AES key schedule.
+class ThreadCipherContexts {
+public:
+    ThreadCipherContexts() : encrypt_(EVP_CIPHER_CTX_new()), decrypt_(EVP_CIPHER_CTX_new()) {}
+
+    ~ThreadCipherContexts() {
+        EVP_CIPHER_CTX_free(encrypt_);
+        EVP_CIPHER_CTX_free(decrypt_);
+    }
+
+    ThreadCipherContexts(const ThreadCipherContexts&) = delete;
+    ThreadCipherContexts& operator=(const ThreadCipherContexts&) = delete;
+
+    EVP_CIPHER_CTX* keyed(bool encrypt, std::uint64_t sessionId, const unsigned char* key) {
+        EVP_CIPHER_CTX* ctx = encrypt ? encrypt_ : decrypt_;
+        std::uint64_t& bound = encrypt ? encryptSession_ : decryptSession_;
+        if (!ctx) {
+            return nullptr;
+        }
+        if (bound != sessionId) {
+            bound = 0;
+            if (EVP_CipherInit_ex(ctx, aes256GcmMethod(), nullptr, key, nullptr, encrypt) != 1) {
+                return nullptr;
+            }
+            bound = sessionId;
+        }
+        return ctx;
+    }
+
+    static ThreadCipherContexts& current() {
+        thread_local ThreadCipherContexts contexts;
+        return contexts;
+    }
+
+private:
+    EVP_CIPHER_CTX* encrypt_;
+    EVP_CIPHER_CTX* decrypt_;
+    std::uint64_t encryptSession_ = 0;
+    std::uint64_t decryptSession_ = 0;
+};
+
+std::atomic<std::uint64_t> nextCipherSessionId{1};
+
+// Largest deflate back-reference distance; also the dictionary size used to
+// prime each parallel block
+constexpr std::size_t kDeflateWindow = 32768;
+
+// Deflate and inflate streams kept per thread and reset between calls
+// instead of re-initialized: zlib-wrapped ones for compress()/decompress()
+// and compressFile, raw ones for the parallel gzip blocks.
+class ThreadZStreams {
+public:
+    ~ThreadZStreams() {
+        if (deflaterReady_) {
+            deflateEnd(&deflater_);
+        }
+        if (inflaterReady_) {
+            inflateEnd(&inflater_);
+        }
+        if (rawDeflaterReady_) {
+            deflateEnd(&rawDeflater_);
+        }
+    }
+
+    z_stream* deflater(int level) {
+        if (!deflaterReady_) {
+            if (deflateInit(&deflater_, level) != Z_OK) {
+                return nullptr;
+            }
+            deflaterReady_ = true;
+            deflaterLevel_ = level;
+            return &deflater_;
+        }
+        deflateReset(&deflater_);
+        if (level != deflaterLevel_) {
+            if (deflateParams(&deflater_, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+                return nullptr;
+            }
+            deflaterLevel_ = level;
+        }
+        return &deflater_;
+    }
+
+    z_stream* rawDeflater(int level) {
+        if (!rawDeflaterReady_) {
+            if (deflateInit2(&rawDeflater_, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                return nullptr;
+            }
+            rawDeflaterReady_ = true;
+            rawDeflaterLevel_ = level;
+            return &rawDeflater_;
+        }
+        deflateReset(&rawDeflater_);
+        if (level != rawDeflaterLevel_) {
+            if (deflateParams(&rawDeflater_, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+                return nullptr;
+            }
+            rawDeflaterLevel_ = level;
+        }
+        return &rawDeflater_;
+    }
+
+    z_stream* inflater() {
+        if (!inflaterReady_) {
+            // 15 + 32: accept both zlib and gzip headers
+            if (inflateInit2(&inflater_, 15 + 32) != Z_OK) {
+                return nullptr;
+            }
+            inflaterReady_ = true;
+            return &inflater_;
+        }
+        inflateReset(&inflater_);
+        return &inflater_;
+    }
+
+    static ThreadZStreams& current() {
+        thread_local ThreadZStreams streams;
+        return streams;
+    }
+
+private:
+    z_stream deflater_{};
+    z_stream inflater_{};
+    bool deflaterReady_ = false;
+    bool inflaterReady_ = false;
+    int deflaterLevel_ = Z_DEFAULT_COMPRESSION;
+    z_stream rawDeflater_{};
+    bool rawDeflaterReady_ = false;
+    int rawDeflaterLevel_ = Z_DEFAULT_COMPRESSION;
+};
+
+struct DeflatedBlock {
+    std::vector<unsigned char> data;
+    uLong crc = 0;
+    std::size_t inputSize = 0;
+    bool ok = false;
+};
+
+std::string_view byteView(const std::vector<unsigned char>& bytes) {
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+// Raw-deflates one block, primed with the tail of previous as dictionary.
+// Non-final blocks end on a byte boundary via Z_SYNC_FLUSH so outputs can
+// be concatenated into a single stream.
+DeflatedBlock deflateBlock(std::string_view input, std::string_view previous, int level, bool last) {
+    DeflatedBlock block;
+    block.inputSize = input.size();
+    block.crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(input.data()),
+                      static_cast<uInt>(input.size()));
+    
+    z_stream* stream = ThreadZStreams::current().rawDeflater(level);
+    if (!stream) {
+        return block;
+    }
+    z_stream& strm = *stream;
+    if (!previous.empty()) {
+        std::size_t dictLen = std::min(previous.size(), kDeflateWindow);
+        deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(previous.data() + previous.size() - dictLen),
+                             static_cast<uInt>(dictLen));
+    }
+    
+    block.data.resize(deflateBound(&strm, static_cast<uLong>(input.size())) + 16);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    strm.avail_in = static_cast<uInt>(input.size());
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int ret;
+    do {
+        if (strm.total_out == block.data.size()) {
+            block.data.resize(block.data.size() * 2);
+        }
+        strm.next_out = block.data.data() + strm.total_out;
+        strm.avail_out = static_cast<uInt>(block.data.size() - strm.total_out);
+        ret = deflate(&strm, flush);
+    } while (ret == Z_OK && (strm.avail_out == 0 || (last && ret != Z_STREAM_END)));
+    
+    block.ok = last ? ret == Z_STREAM_END : ret == Z_OK || ret == Z_BUF_ERROR;
+    block.data.resize(strm.total_out);
+    return block;
+}
+
+// Double-buffered file reader: while the caller consumes one buffer, the
+// next one is filled on the worker pool. Without a pool the read is done
+// synchronously in next().
+class ReadAhead {
+public:
+    ReadAhead(std::istream& input, WorkerPool* pool, std::size_t bufferSize)
+        : input_(input), pool_(pool) {
+        buffers_[0].resize(bufferSize);
+        buffers_[1].resize(bufferSize);
+        startRead(0);
+    }
+
+    ~ReadAhead() {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    // Next chunk of the file; empty once the input is exhausted. The view
+    // stays valid until the following call.
+    std::string_view next() {
+        std::size_t filled = pending_.valid() ? pending_.get() : fill(buffers_[ready_]);
+        std::size_t current = ready_;
+        if (filled > 0) {
+            startRead(1 - current);
+        }
+        return {buffers_[current].data(), filled};
+    }
+
+    bool failed() const { return input_.bad(); }
+
+private:
+    void startRead(std::size_t index) {
+        ready_ = index;
+        if (pool_) {
+            pending_ = pool_->submit([this, index]() { return fill(buffers_[index]); });
+        }
+    }
+
+    std::size_t fill(std::vector<char>& buffer) {
+        input_.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        return static_cast<std::size_t>(input_.gcount());
+    }
+
+    std::istream& input_;
+    WorkerPool* pool_;
+    std::vector<char> buffers_[2];
+    std::size_t ready_ = 0;
+    std::future<std::size_t> pending_;
+};
+
+// Sealed archive layout: "DPSA", version byte, block size (u32 LE) and the
+// stream nonce, then one record per block: u32 LE length (high bit marks
+// the final record) followed by a CipherSession chunk holding that block's
+// raw deflate output. The deflate blocks concatenate into a single stream.
+constexpr char kSealedMagic[4] = {'D', 'P', 'S', 'A'};
+constexpr unsigned char kSealedVersion = 1;
+constexpr std::size_t kSealedHeaderSize = sizeof(kSealedMagic) + 1 + 4 + CipherSession::kNonceSize;
+constexpr std::uint32_t kSealedLastRecord = 0x80000000u;
+
+void putLe32(unsigned char* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getLe32(const unsigned char* in) {
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+// Largest record a writer with the given block size can produce
+std::size_t maxSealedRecord(std::size_t blockSize) {
+    return compressBound(static_cast<uLong>(blockSize)) + 64 + CipherSession::kTagSize;
+}
+
+// Push side of the compress-then-encrypt pipeline. Input is cut into
+// blocks; each block is deflated (primed with the previous block) and
+// sealed in one pool task, and finished records are written in order by
+// the pushing thread. At most window blocks are in flight, which bounds
+// memory regardless of input size.
+class SealedWriter {
+public:
+    SealedWriter(std::ostream& output, const CipherSession& session, WorkerPool* pool,
+                 const CompressionOptions& options)
+        : output_(output), session_(session), pool_(pool), level_(options.level),
+          blockSize_(std::min<std::size_t>(std::max<std::size_t>(options.blockSize, kDeflateWindow), 1u << 30)),
+          window_(pool ? 2 * pool->threadCount() : 1) {
+        ok_ = session_.ok() && CipherSession::newNonce(nonce_);
+        if (ok_) {
+            unsigned char header[kSealedHeaderSize];
+            std::copy(std::begin(kSealedMagic), std::end(kSealedMagic), header);
+            header[4] = kSealedVersion;
+            putLe32(header + 5, static_cast<std::uint32_t>(blockSize_));
+            std::copy(nonce_.begin(), nonce_.end(), header + 9);
+            output_.write(reinterpret_cast<const char*>(header), sizeof(header));
+        }
+        pending_ = std::make_shared<std::vector<unsigned char>>();
+        pending_->reserve(blockSize_);
+    }
+
+    // Tasks reference the session; never return before they finish
+    ~SealedWriter() {
+        for (auto& record : inFlight_) {
+            record.wait();
+        }
+    }
+
+    SealedWriter(const SealedWriter&) = delete;
+    SealedWriter& operator=(const SealedWriter&) = delete;
+
+    bool write(std::string_view data) {
+        while (ok_ && !data.empty()) {
+            // A full block is only submitted once more input shows it is not the last
+            if (pending_->size() == blockSize_) {
+                submit(false);
+            }
+            std::size_t take = std::min(data.size(), blockSize_ - pending_->size());
+            pending_->insert(pending_->end(), data.begin(), data.begin() + take);
+            data.remove_prefix(take);
+        }
+        return ok_;
+    }
+
+    bool finish() {
+        if (ok_) {
+            submit(true);
+        }
+        while (!inFlight_.empty()) {
+            writeOldest();
+        }
+        output_.flush();
+        return ok_ && static_cast<bool>(output_);
+    }
+
+    std::uint64_t bytesIn() const { return bytesIn_; }
+
+private:
+    void submit(bool last) {
+        std::shared_ptr<const std::vector<unsigned char>> current = std::move(pending_);
+        auto task = [current, previous = previous_, session = &session_, nonce = nonce_,
+                     index = index_++, level = level_, last]() {
+            std::vector<char> record;
+            DeflatedBlock block = deflateBlock(byteView(*current), previous ? byteView(*previous) : std::string_view(),
+                                               level, last);
+            if (!block.ok) {
+                return record;
+            }
+            record.resize(4 + block.data.size() + CipherSession::kTagSize);
+            std::uint32_t length = static_cast<std::uint32_t>(record.size() - 4);
+            putLe32(reinterpret_cast<unsigned char*>(record.data()), length | (last ? kSealedLastRecord : 0));
+            std::string_view plain(reinterpret_cast<const char*>(block.data.data()), block.data.size());
+            if (!session->sealChunk(nonce, index, last, plain, record.data() + 4)) {
+                record.clear();
+            }
+            return record;
+        };
+        if (pool_) {
+            inFlight_.push_back(pool_->submit(std::move(task)));
+        } else {
+            std::promise<std::vector<char>> done;
+            done.set_value(task());
+            inFlight_.push_back(done.get_future());
+        }
+        bytesIn_ += current->size();
+        previous_ = std::move(current);
+        pending_ = std::make_shared<std::vector<unsigned char>>();
+        pending_->reserve(blockSize_);
+        
+        if (inFlight_.size() >= window_) {
+            writeOldest();
+        }
+    }
+
+    void writeOldest() {
+        std::vector<char> record = inFlight_.front().get();
+        inFlight_.pop_front();
+        ok_ = ok_ && !record.empty();
+        if (ok_) {
+            output_.write(record.data(), static_cast<std::streamsize>(record.size()));
+            ok_ = static_cast<bool>(output_);
+        }
+    }
+
+    std::ostream& output_;
+    const CipherSession& session_;
+    WorkerPool* pool_;
+    const int level_;
+    const std::size_t blockSize_;
+    const std::size_t window_;
+    CipherSession::Nonce nonce_{};
+    std::uint64_t index_ = 0;
+    std::uint64_t bytesIn_ = 0;
+    bool ok_ = false;
+    std::shared_ptr<std::vector<unsigned char>> pending_;
+    std::shared_ptr<const std::vector<unsigned char>> previous_;
+    std::deque<std::future<std::vector<char>>> inFlight_;
+};
+
+// Pull side: records are read and authenticated ahead on the pool while
+// the calling thread inflates them in order into the sink. Fails unless
+// every record opens and the final one is present.
+bool readSealedArchive(std::istream& input, const CipherSession& session, WorkerPool* pool, const ChunkSink& sink) {
+    unsigned char header[kSealedHeaderSize];
+    input.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (input.gcount() != static_cast<std::streamsize>(sizeof(header)) ||
+        !std::equal(std::begin(kSealedMagic), std::end(kSealedMagic), header) || header[4] != kSealedVersion ||
+        !session.ok()) {
+        return false;
+    }
+    const std::size_t maxRecord = maxSealedRecord(getLe32(header + 5));
+    CipherSession::Nonce nonce;
+    std::copy(header + 9, header + kSealedHeaderSize, nonce.begin());
+    
+    z_stream strm{};
+    if (inflateInit2(&strm, -15) != Z_OK) {
+        return false;
+    }
+    std::vector<char> out(256 * 1024);
+    int ret = Z_OK;
+    bool ok = true;
+    
+    auto inflateOldest = [&](std::deque<std::future<std::vector<char>>>& inFlight) {
+        std::vector<char> block = inFlight.front().get();
+        inFlight.pop_front();
+        if (!ok || block.empty() || ret == Z_STREAM_END) {
+            ok = false;
+            return;
+        }
+        strm.next_in = reinterpret_cast<Bytef*>(block.data());
+        strm.avail_in = static_cast<uInt>(block.size());
+        do {
+            strm.next_out = reinterpret_cast<Bytef*>(out.data());
+            strm.avail_out = static_cast<uInt>(out.size());
+            ret = inflate(&strm, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                ok = false;
+                return;
+            }
+            std::size_t have = out.size() - strm.avail_out;
+            if (have > 0 && !sink(std::string_view(out.data(), have))) {
+                ok = false;
+                return;
+            }
+        } while (strm.avail_out == 0);
+        // A block's input must be consumed exactly; the stream ends only in the last one
+        ok = strm.avail_in == 0;
+    };
+    
+    const std::size_t window = pool ? 2 * pool->threadCount() : 1;
+    std::deque<std::future<std::vector<char>>> inFlight;
+    bool sawLast = false;
+    for (std::uint64_t index = 0; ok; ++index) {
+        unsigned char prefix[4];
+        input.read(reinterpret_cast<char*>(prefix), sizeof(prefix));
+        if (input.gcount() == 0 && input.eof()) {
+            break;
+        }
+        const std::uint32_t word = getLe32(prefix);
+        const std::size_t length = word & ~kSealedLastRecord;
+        const bool last = (word & kSealedLastRecord) != 0;
+        if (input.gcount() != 4 || sawLast || length < CipherSession::kTagSize || length > maxRecord) {
+            ok = false;
+            break;
+        }
+        auto sealed = std::make_shared<std::vector<char>>(length);
+        input.read(sealed->data(), static_cast<std::streamsize>(length));
+        if (input.gcount() != static_cast<std::streamsize>(length)) {
+            ok = false;
+            break;
+        }
+        sawLast = last;
+        
+        auto task = [sealed, session = &session, nonce, index, last]() {
+            std::vector<char> plain(sealed->size() - CipherSession::kTagSize);
+            if (plain.empty() ||
+                !session->openChunk(nonce, index, last, std::string_view(sealed->data(), sealed->size()), plain.data())) {
+                plain.clear();
+            }
+            return plain;
+        };
+        if (pool) {
+            inFlight.push_back(pool->submit(std::move(task)));
+        } else {
+            std::promise<std::vector<char>> done;
+            done.set_value(task());
+            inFlight.push_back(done.get_future());
+        }
+        if (inFlight.size() >= window) {
+            inflateOldest(inFlight);
+        }
+    }
+    while (!inFlight.empty()) {
+        inflateOldest(inFlight);
+    }
+    
+    inflateEnd(&strm);
+    return ok && sawLast && ret == Z_STREAM_END;
+}
+
+// Shared state of one processFilesInDirectory call. pending counts queued
+// or running directory tasks; the caller waits for it to reach zero.
+struct DirectoryScan {
+    explicit DirectoryScan(const FileVisitor& fileVisitor) : visitor(fileVisitor) {}
+
+    void enter() {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+    }
+
+    void leave() {
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = --pending == 0;
+        }
+        if (finished) {
+            done.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    void addError(std::string error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors.push_back(std::move(error));
+    }
+
+    const FileVisitor& visitor;
+    std::atomic<std::size_t> files{0};
+    std::atomic<std::size_t> directories{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending = 0;
+    std::vector<std::string> errors;
+};
+
+// Read-only WAL connection for queryData, used by one query at a time.
+// Statements are prepared once per SQL text and reset after each use; the
+// cache is dropped wholesale when it fills, so ad-hoc SQL can't grow it.
+class ReadConnection {
+public:
+    static constexpr std::size_t kStatementCacheSize = 64;
+
+    explicit ReadConnection(const std::string& path) {
+        if (sqlite3_open_v2(path.c_str(), &db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+            sqlite3_close(db_);
+            db_ = nullptr;
+            return;
+        }
+        // Readers only wait during WAL recovery or a checkpoint restart
+        sqlite3_busy_timeout(db_, 5000);
+    }
+
+    ~ReadConnection() {
+        clearStatements();
+        sqlite3_close(db_);
+    }
+
+    ReadConnection(const ReadConnection&) = delete;
+    ReadConnection& operator=(const ReadConnection&) = delete;
+
+    bool ok() const { return db_ != nullptr; }
+    sqlite3* handle() const { return db_; }
+
+    sqlite3_stmt* statement(const std::string& sql) {
+        auto it = statements_.find(sql);
+        if (it != statements_.end()) {
+            return it->second;
+        }
+        if (statements_.size() >= kStatementCacheSize) {
+            clearStatements();
+        }
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()), SQLITE_PREPARE_PERSISTENT,
+                               &stmt, nullptr) != SQLITE_OK) {
+            return nullptr;
+        }
+        statements_.emplace(sql, stmt);
+        return stmt;
+    }
+
+private:
+    void clearStatements() {
+        for (auto& entry : statements_) {
+            sqlite3_finalize(entry.second);
+        }
+        statements_.clear();
+    }
+
+    sqlite3* db_ = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> statements_;
+};
+
+// Size and modification time of a file as stored in file_index, from one
+// stat call. The mtime is in nanoseconds, so a same-size rewrite within the
+// second after indexing still reads as a change.
+boost::system::error_code statForIndex(const std::string& path, std::int64_t& size, std::int64_t& mtime) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return boost::system::error_code(errno, boost::system::system_category());
+    }
+    size = static_cast<std::int64_t>(info.st_size);
+    mtime = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return {};
+}
+
+// Row of file_index as seen by indexDirectory; seen is set concurrently by
+// scan workers for every file still present on disk.
+struct IndexedFile {
+    IndexedFile(std::int64_t fileSize, std::int64_t fileMtime) : size(fileSize), mtime(fileMtime) {}
+
+    std::int64_t size;
+    std::int64_t mtime;
+    std::atomic<bool> seen{false};
+};
+
+struct IndexUpdate {
+    std::string path;
+    std::int64_t size;
+    std::int64_t mtime;
+    std::string hash;
+    bool added;
+};
+
+// Bounded queue between two runBatch stages. Producers block while it is
+// full and consumers while it is empty; both report how long they waited.
+// After close() consumers drain what is left and then get false.
+template <typename T>
+class StageQueue {
+public:
+    explicit StageQueue(std::size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+
+    // Returns nanoseconds spent waiting for space
+    std::uint64_t push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::uint64_t waited = 0;
+        if (items_.size() >= capacity_) {
+            const auto start = std::chrono::steady_clock::now();
+            notFull_.wait(lock, [this]() { return items_.size() < capacity_; });
+            waited = elapsedNanos(start);
+        }
+        items_.push_back(std::move(value));
+        maxDepth_ = std::max(maxDepth_, items_.size());
+        depthSum_ += items_.size();
+        ++pushes_;
+        lock.unlock();
+        notEmpty_.notify_one();
+        return waited;
+    }
+
+    // Like push, but returns false instead of waiting; value is then untouched
+    bool tryPush(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (items_.size() >= capacity_) {
+            return false;
+        }
+        items_.push_back(std::move(value));
+        maxDepth_ = std::max(maxDepth_, items_.size());
+        depthSum_ += items_.size();
+        ++pushes_;
+        lock.unlock();
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& value, std::uint64_t& waitedNanos) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitedNanos = 0;
+        if (items_.empty() && !closed_) {
+            const auto start = std::chrono::steady_clock::now();
+            notEmpty_.wait(lock, [this]() { return !items_.empty() || closed_; });
+            waitedNanos = elapsedNanos(start);
+        }
+        if (items_.empty()) {
+            return false;
+        }
+        value = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+    }
+
+    std::size_t maxDepth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maxDepth_;
+    }
+
+    double meanDepth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pushes_ == 0 ? 0.0 : static_cast<double>(depthSum_) / static_cast<double>(pushes_);
+    }
+
+private:
+    static std::uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    std::size_t maxDepth_ = 0;
+    std::uint64_t depthSum_ = 0;
+    std::uint64_t pushes_ = 0;
+};
+
+// One file moving through runBatch. A stage that fails sets error; later
+// stages pass the item along untouched so it is still counted.
+struct BatchItem {
+    std::string path;
+    std::string relative;
+    std::int64_t size = 0;
+    std::int64_t mtime = 0;
+    MappedBuffer data;
+    std::string hash;
+    // Compressed, then sealed in place of the compressed bytes
+    std::string payload;
+    std::string error;
+};
+
+// Per-stage counters. busyNanos is added to from pool tasks; the rest only
+// by the stage's own thread.
+struct BatchStageCounters {
+    std::atomic<std::uint64_t> items{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> busyNanos{0};
+    std::uint64_t inputWaitNanos = 0;
+    std::uint64_t outputWaitNanos = 0;
+};
+
+// "batch" section of generateJsonReport; rates are over the job's wall time
+json batchReportJson(const BatchReport& report) {
+    json stages = json::array();
+    const double seconds = report.seconds > 0.0 ? report.seconds : 1.0;
+    for (const BatchStageStats& stage : report.stages) {
+        stages.push_back({
+            {"name", stage.name},
+            {"items", stage.items},
+            {"bytes", stage.bytes},
+            {"items_per_second", static_cast<double>(stage.items) / seconds},
+            {"mb_per_second", static_cast<double>(stage.bytes) / seconds / (1024.0 * 1024.0)},
+            {"busy_seconds", stage.busySeconds},
+            {"input_wait_seconds", stage.inputWaitSeconds},
+            {"output_wait_seconds", stage.outputWaitSeconds},
+            {"queue_depth_max", stage.maxQueueDepth},
+            {"queue_depth_mean", stage.meanQueueDepth},
+        });
+    }
+    json result = {
+        {"ok", report.ok},
+        {"files", report.files},
+        {"failed", report.failed},
+        {"bytes_in", report.bytesIn},
+        {"bytes_out", report.bytesOut},
+        {"seconds", report.seconds},
+        {"stages", stages},
+    };
+    if (!report.firstError.empty()) {
+        result["first_error"] = report.firstError;
+    }
+    return result;
+}
+
+enum class CompressionFormat { Unknown, Gzip, Zlib, Bzip2 };
+
+CompressionFormat detectCompressionFormat(std::string_view head) {
+    auto byte = [&head](std::size_t i) { return static_cast<unsigned char>(head[i]); };
+    if (head.size() >= 2 && byte(0) == 0x1f && byte(1) == 0x8b) {
+        return CompressionFormat::Gzip;
+    }
+    if (head.size() >= 3 && head.compare(0, 3, "BZh") == 0) {
+        return CompressionFormat::Bzip2;
+    }
+    if (head.size() >= 2 && (byte(0) & 0x0f) == Z_DEFLATED && (byte(0) * 256 + byte(1)) % 31 == 0) {
+        return CompressionFormat::Zlib;
+    }
+    return CompressionFormat::Unknown;
+}
+
+struct HttpRequest {
+    std::string url;
+    // "first-last" byte range; empty for the whole body
+    std::string range;
+    // Byte offset to continue a partial body from, 0 for none
+    curl_off_t resumeFrom = 0;
+    // Fetch headers only, for the content length
+    bool headOnly = false;
+};
+
+// Event-loop HTTP client on a single curl multi handle. One thread drives
+// every transfer; at most maxConcurrentTransfers run at once and the rest
+// wait in FIFO order. The multi handle pools connections and multiplexes
+// HTTP/2 streams per host; DNS and TLS sessions are kept in a CURLSH. All
+// handles are used only by the loop thread, so the share needs no locks.
+class HttpClient {
+public:
+    explicit HttpClient(const HttpOptions& options)
+        : options_(options), multi_(curl_multi_init()), share_(curl_share_init()) {
+        if (options_.maxConcurrentTransfers == 0) {
+            options_.maxConcurrentTransfers = 1;
+        }
+        if (share_) {
+            curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+        if (multi_) {
+            curl_multi_setopt(multi_, CURLMOPT_PIPELINING, options_.http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+            curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options_.maxHostConnections));
+            loop_ = std::thread([this]() { run(); });
+        }
+    }
+
+    // Transfers still queued or running are failed, not awaited
+    ~HttpClient() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        if (loop_.joinable()) {
+            curl_multi_wakeup(multi_);
+            loop_.join();
+        }
+        for (CURL* easy : idle_) {
+            curl_easy_cleanup(easy);
+        }
+        if (multi_) {
+            curl_multi_cleanup(multi_);
+        }
+        if (share_) {
+            curl_share_cleanup(share_);
+        }
+    }
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    bool ok() const { return loop_.joinable(); }
+
+    // A pausable sink answers each chunk. Pause leaves the chunk unconsumed
+    // and parks only that transfer; curl hands the chunk over again once
+    // resume() is called with the id fetch() gave out.
+    enum class SinkStatus { Accept, Pause, Abort };
+    using PausableSink = std::function<SinkStatus(std::string_view)>;
+
+    // Only the network schemes can pause; curl reads file:// and the like
+    // in one go inside the loop, and fails a transfer whose sink pauses
+    static bool canPause(const std::string& url) {
+        std::unique_ptr<CURLU, void (*)(CURLU*)> parsed(curl_url(), curl_url_cleanup);
+        char* scheme = nullptr;
+        if (!parsed || curl_url_set(parsed.get(), CURLUPART_URL, url.c_str(), 0) != CURLUE_OK ||
+            curl_url_get(parsed.get(), CURLUPART_SCHEME, &scheme, 0) != CURLUE_OK) {
+            return false;
+        }
+        const bool network = std::strcmp(scheme, "http") == 0 || std::strcmp(scheme, "https") == 0;
+        curl_free(scheme);
+        return network;
+    }
+
+    // Without a sink the body is collected into the response. The sink runs
+    // on the loop thread and should hand heavy work off rather than block.
+    // onDone, if set, also runs on the loop thread, after the last sink call
+    // and however the transfer ends.
+    std::future<HttpResponse> fetch(HttpRequest request, ChunkSink sink = nullptr,
+                                    std::function<void()> onDone = nullptr) {
+        auto transfer = std::make_unique<Transfer>();
+        transfer->sink = std::move(sink);
+        std::uint64_t id = 0;
+        return enqueue(std::move(request), std::move(transfer), std::move(onDone), id);
+    }
+
+    std::future<HttpResponse> fetch(HttpRequest request, PausableSink sink, std::function<void()> onDone,
+                                    std::uint64_t& id) {
+        auto transfer = std::make_unique<Transfer>();
+        transfer->pausableSink = std::move(sink);
+        return enqueue(std::move(request), std::move(transfer), std::move(onDone), id);
+    }
+
+    // Unpauses a transfer its sink paused. Safe from any thread, and a no-op
+    // for a transfer that isn't paused or has finished.
+    void resume(std::uint64_t id) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            resumes_.push_back(id);
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+private:
+    struct Transfer;
+
+    std::future<HttpResponse> enqueue(HttpRequest request, std::unique_ptr<Transfer> transfer,
+                                      std::function<void()> onDone, std::uint64_t& id) {
+        transfer->request = std::move(request);
+        transfer->onDone = std::move(onDone);
+        std::future<HttpResponse> future = transfer->done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            id = transfer->id = ++nextTransferId_;
+            if (stopping_ || !ok()) {
+                transfer->response.error = "HTTP client not running";
+                complete(*transfer);
+                return future;
+            }
+            waiting_.push_back(std::move(transfer));
+        }
+        curl_multi_wakeup(multi_);
+        return future;
+    }
+
+    struct Transfer {
+        HttpRequest request;
+        std::uint64_t id = 0;
+        ChunkSink sink;
+        PausableSink pausableSink;
+        std::function<void()> onDone;
+        HttpResponse response;
+        std::promise<HttpResponse> done;
+        char error[CURL_ERROR_SIZE] = {};
+    };
+
+    static void complete(Transfer& transfer) {
+        if (transfer.onDone) {
+            transfer.onDone();
+        }
+        transfer.done.set_value(std::move(transfer.response));
+    }
+
+    static size_t writeBody(char* data, size_t size, size_t count, void* userdata) {
+        auto* transfer = static_cast<Transfer*>(userdata);
+        std::string_view chunk(data, size * count);
+        try {
+            // Returning short aborts the transfer with CURLE_WRITE_ERROR
+            if (transfer->pausableSink) {
+                switch (transfer->pausableSink(chunk)) {
+                case SinkStatus::Accept:
+                    return chunk.size();
+                case SinkStatus::Pause:
+                    return CURL_WRITEFUNC_PAUSE;
+                case SinkStatus::Abort:
+                    return 0;
+                }
+            }
+            if (!transfer->sink) {
+                transfer->response.body.append(chunk.data(), chunk.size());
+                return chunk.size();
+            }
+            return transfer->sink(chunk) ? chunk.size() : 0;
+        } catch (...) {
+            return 0;
+        }
+    }
+
+    void run() {
+        std::unordered_map<CURL*, std::unique_ptr<Transfer>> active;
+        std::vector<std::uint64_t> resumes;
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) {
+                    break;
+                }
+                resumes.swap(resumes_);
+                while (!waiting_.empty() && active.size() < options_.maxConcurrentTransfers) {
+                    std::unique_ptr<Transfer> transfer = std::move(waiting_.front());
+                    waiting_.pop_front();
+                    CURL* easy = start(*transfer);
+                    if (easy) {
+                        active.emplace(easy, std::move(transfer));
+                    } else {
+                        transfer->response.error = "Failed to start transfer";
+                        complete(*transfer);
+                    }
+                }
+            }
+            
+            // Unpausing may call the write callback straight away, so it
+            // happens outside the lock
+            for (std::uint64_t id : resumes) {
+                for (auto& entry : active) {
+                    if (entry.second->id == id) {
+                        curl_easy_pause(entry.first, CURLPAUSE_CONT);
+                    }
+                }
+            }
+            resumes.clear();
+            
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+            int queued = 0;
+            while (CURLMsg* msg = curl_multi_info_read(multi_, &queued)) {
+                if (msg->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                auto it = active.find(msg->easy_handle);
+                if (it != active.end()) {
+                    finish(msg->easy_handle, msg->data.result, *it->second);
+                    active.erase(it);
+                }
+            }
+            curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : active) {
+            curl_multi_remove_handle(multi_, entry.first);
+            curl_easy_cleanup(entry.first);
+            entry.second->response.error = "HTTP client shut down";
+            complete(*entry.second);
+        }
+        for (auto& transfer : waiting_) {
+            transfer->response.error = "HTTP client shut down";
+            complete(*transfer);
+        }
+        waiting_.clear();
+    }
+
+    // Idle easy handles are reset and reused, keeping their buffers
+    CURL* start(Transfer& transfer) {
+        CURL* easy = nullptr;
+        if (!idle_.empty()) {
+            easy = idle_.back();
+            idle_.pop_back();
+            curl_easy_reset(easy);
+        } else {
+            easy = curl_easy_init();
+        }
+        if (!easy) {
+            return nullptr;
+        }
+        
+        const HttpRequest& request = transfer.request;
+        curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &HttpClient::writeBody);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.error);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT, options_.timeoutSeconds);
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, options_.http2 ? CURL_HTTP_VERSION_2TLS : CURL_HTTP_VERSION_1_1);
+        // Wait for an existing connection to accept another stream rather than open a new one
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, options_.http2 ? 1L : 0L);
+        if (!request.range.empty()) {
+            curl_easy_setopt(easy, CURLOPT_RANGE, request.range.c_str());
+        }
+        if (request.resumeFrom > 0) {
+            curl_easy_setopt(easy, CURLOPT_RESUME_FROM_LARGE, request.resumeFrom);
+        }
+        if (request.headOnly) {
+            curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+        }
+        
+        if (curl_multi_add_handle(multi_, easy) != CURLM_OK) {
+            curl_easy_cleanup(easy);
+            return nullptr;
+        }
+        return easy;
+    }
+
+    void finish(CURL* easy, CURLcode result, Transfer& transfer) {
+        curl_multi_remove_handle(multi_, easy);
+        long status = 0;
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+        transfer.response.status = status;
+        curl_off_t length = -1;
+        if (curl_easy_getinfo(easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK) {
+            transfer.response.contentLength = static_cast<std::int64_t>(length);
+        }
+        transfer.response.ok = result == CURLE_OK;
+        if (!transfer.response.ok) {
+            transfer.response.error = transfer.error[0] ? transfer.error : curl_easy_strerror(result);
+        }
+        idle_.push_back(easy);
+        complete(transfer);
+    }
+
+    HttpOptions options_;
+    CURLM* multi_;
+    CURLSH* share_;
+    std::vector<CURL*> idle_;
+    std::mutex mutex_;
+    std::deque<std::unique_ptr<Transfer>> waiting_;
+    std::vector<std::uint64_t> resumes_;
+    std::uint64_t nextTransferId_ = 0;
+    bool stopping_ = false;
+    std::thread loop_;
+};
+
+// True when every byte is 7-bit. Checks eight bytes per step; compilers
+// vectorize the OR-reduction, so long ASCII runs cost a few cycles per
+// 16-32 bytes.
+bool isAscii(std::string_view data) {
+    const char* p = data.data();
+    const char* end = p + data.size();
+    std::uint64_t bits = 0;
+    for (; end - p >= 32; p += 32) {
+        std::uint64_t words[4];
+        std::memcpy(words, p, sizeof(words));
+        bits |= words[0] | words[1] | words[2] | words[3];
+        if (bits & 0x8080808080808080ULL) {
+            return false;
+        }
+    }
+    for (; p < end; ++p) {
+        bits |= static_cast<unsigned char>(*p);
+    }
+    return (bits & 0x8080808080808080ULL) == 0;
+}
+
+// Encodings that store 7-bit ASCII as itself, so ASCII input converts
+// between any two of them unchanged. Everything else (UTF-16/32, EBCDIC,
+// ISO-2022) always goes through iconv.
+bool asciiCompatible(const std::string& encoding) {
+    std::string name;
+    for (char c : encoding) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            name += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+    }
+    for (const char* prefix : {"UTF8", "ASCII", "USASCII", "ANSIX341968", "ISO8859", "LATIN", "CP125", "WINDOWS125"}) {
+        if (name.compare(0, std::strlen(prefix), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// iconv descriptors kept per thread and per (from, to) pair, reset between
+// uses instead of reopened. A descriptor is stateful, so a pair already in
+// use on this thread (a visitor converting mid-stream) gets a private one.
+class ThreadIconv {
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(iconv_t cd, bool* inUse) : cd_(cd), inUse_(inUse) {}
+        ~Lease() { release(); }
+        Lease(Lease&& other) noexcept { *this = std::move(other); }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                std::swap(cd_, other.cd_);
+                std::swap(inUse_, other.inUse_);
+            }
+            return *this;
+        }
+
+        explicit operator bool() const { return cd_ != invalid(); }
+        iconv_t get() const { return cd_; }
+
+    private:
+        void release() {
+            if (inUse_) {
+                *inUse_ = false;
+            } else if (cd_ != invalid()) {
+                iconv_close(cd_);
+            }
+            cd_ = invalid();
+            inUse_ = nullptr;
+        }
+
+        iconv_t cd_ = invalid();
+        bool* inUse_ = nullptr;
+    };
+
+    ~ThreadIconv() {
+        for (auto& entry : descriptors_) {
+            iconv_close(entry.second.cd);
+        }
+    }
+
+    // Invalid lease when iconv has no such conversion
+    Lease acquire(const std::string& from, const std::string& to) {
+        std::string key = from;
+        key += '\0';
+        key += to;
+        auto it = descriptors_.find(key);
+        if (it == descriptors_.end()) {
+            iconv_t cd = iconv_open(to.c_str(), from.c_str());
+            if (cd == invalid()) {
+                return Lease();
+            }
+            it = descriptors_.emplace(std::move(key), Cached{cd, false}).first;
+        } else if (it->second.inUse) {
+            return Lease(iconv_open(to.c_str(), from.c_str()), nullptr);
+        } else {
+            iconv(it->second.cd, nullptr, nullptr, nullptr, nullptr);
+        }
+        it->second.inUse = true;
+        return Lease(it->second.cd, &it->second.inUse);
+    }
+
+    static ThreadIconv& current() {
+        thread_local ThreadIconv descriptors;
+        return descriptors;
+    }
+
+    static iconv_t invalid() { return reinterpret_cast<iconv_t>(-1); }
+
+private:
+    struct Cached {
+        iconv_t cd;
+        bool inUse;
+    };
+    // Node-based, so inUse flags stay put while leases hold them
+    std::unordered_map<std::string, Cached> descriptors_;
+};
+
+// Incremental charset conversion. Chunks may split a multibyte sequence;
+// the tail is held back until the next chunk. Pure-ASCII chunks between
+// ASCII-compatible encodings skip iconv. A lease must be used on the
+// thread that created it.
+class EncodingConverter {
+public:
+    EncodingConverter(const std::string& from, const std::string& to)
+        : lease_(ThreadIconv::current().acquire(from, to)),
+          passThrough_(asciiCompatible(from) && asciiCompatible(to)) {
+        if (!lease_) {
+            error_ = fmt::format("Unsupported conversion from {} to {}", from, to);
+        }
+    }
+
+    bool ok() const { return static_cast<bool>(lease_) && error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    // True when chunk can be used as-is, without going through feed()
+    bool passesThrough(std::string_view chunk) const {
+        return passThrough_ && ok() && pending_.empty() && isAscii(chunk);
+    }
+
+    // Appends the converted chunk to output
+    bool feed(std::string_view chunk, std::string& output) {
+        if (!ok()) {
+            return false;
+        }
+        if (passesThrough(chunk)) {
+            output.append(chunk.data(), chunk.size());
+            consumed_ += chunk.size();
+            return true;
+        }
+        if (pending_.empty()) {
+            return convert(chunk, output);
+        }
+        std::string joined;
+        joined.swap(pending_);
+        joined.append(chunk.data(), chunk.size());
+        return convert(joined, output);
+    }
+
+    // Writes any closing shift sequence; fails on a truncated final sequence
+    bool finish(std::string& output) {
+        if (!ok()) {
+            return false;
+        }
+        if (!pending_.empty()) {
+            error_ = fmt::format("Incomplete multibyte sequence at offset {}", consumed_);
+            return false;
+        }
+        char buffer[64];
+        char* out = buffer;
+        std::size_t outLeft = sizeof(buffer);
+        if (iconv(lease_.get(), nullptr, nullptr, &out, &outLeft) == static_cast<std::size_t>(-1)) {
+            error_ = "Failed to finish conversion";
+            return false;
+        }
+        output.append(buffer, sizeof(buffer) - outLeft);
+        return true;
+    }
+
+private:
+    bool convert(std::string_view chunk, std::string& output) {
+        char* in = const_cast<char*>(chunk.data());
+        std::size_t inLeft = chunk.size();
+        while (inLeft > 0) {
+            // Room for UTF-16 -> UTF-8 (3 bytes per 2) or Latin-1 -> UTF-8 (2 per 1)
+            const std::size_t used = output.size();
+            output.resize(used + std::max<std::size_t>(2 * inLeft, 64));
+            char* out = &output[used];
+            std::size_t outLeft = output.size() - used;
+            const std::size_t before = inLeft;
+            const std::size_t rc = iconv(lease_.get(), &in, &inLeft, &out, &outLeft);
+            const int err = errno;
+            output.resize(output.size() - outLeft);
+            consumed_ += before - inLeft;
+            if (rc != static_cast<std::size_t>(-1)) {
+                continue;
+            }
+            if (err == E2BIG) {
+                continue;
+            }
+            if (err == EINVAL) {
+                pending_.assign(in, inLeft);
+                return true;
+            }
+            error_ = fmt::format("Invalid or unconvertible byte sequence at offset {}", consumed_);
+            return false;
+        }
+        return true;
+    }
+
+    ThreadIconv::Lease lease_;
+    const bool passThrough_;
+    std::string pending_;
+    std::string error_;
+    std::size_t consumed_ = 0;
+};
+
+// Counts top-level members or elements, as json::size() would, without
+// building a DOM
+class JsonElementCounter {
+public:
+    std::size_t count() const { return count_; }
+    const std::string& error() const { return error_; }
+
+    bool null() { return element(); }
+    bool boolean(bool) { return element(); }
+    bool number_integer(json::number_integer_t) { return element(); }
+    bool number_unsigned(json::number_unsigned_t) { return element(); }
+    bool number_float(json::number_float_t, const json::string_t&) { return element(); }
+    bool string(json::string_t&) { return element(); }
+    bool binary(json::binary_t&) { return element(); }
+    bool start_object(std::size_t) { return enter(false); }
+    bool start_array(std::size_t) { return enter(true); }
+    bool end_object() { return leave(); }
+    bool end_array() { return leave(); }
+    bool key(json::string_t&) {
+        count_ += frames_.size() == 1 ? 1 : 0;
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        error_ = e.what();
+        return false;
+    }
+
+private:
+    // A top-level scalar has size 1; otherwise count direct array elements
+    bool element() {
+        count_ += frames_.empty() || (frames_.size() == 1 && frames_.back()) ? 1 : 0;
+        return true;
+    }
+    bool enter(bool array) {
+        if (!frames_.empty()) {
+            element();
+        }
+        frames_.push_back(array);
+        return true;
+    }
+    bool leave() {
+        frames_.pop_back();
+        return true;
+    }
+
+    std::vector<bool> frames_;
+    std::size_t count_ = 0;
+    std::string error_;
+};
+
+// Per-thread bump allocator for JSON parsing scratch (the lexer's token
+// buffer and string values). Deallocation is a no-op; the arena is
+// recycled wholesale when the outermost ArenaScope on the thread ends,
+// i.e. after each NDJSON record, keeping its largest block for reuse.
+class ThreadArena {
+public:
+    static ThreadArena& current() {
+        thread_local ThreadArena arena;
+        return arena;
+    }
+
+    void* allocate(std::size_t size, std::size_t align) {
+        std::size_t offset = (used_ + align - 1) & ~(align - 1);
+        if (blocks_.empty() || offset + size > blocks_.back().size) {
+            std::size_t blockSize = std::max(kBlockSize, size + align);
+            blocks_.push_back({std::make_unique<unsigned char[]>(blockSize), blockSize});
+            offset = 0;
+        }
+        used_ = offset + size;
+        return blocks_.back().data.get() + offset;
+    }
+
+    void enter() { ++depth_; }
+
+    void leave() {
+        if (--depth_ == 0 && !blocks_.empty()) {
+            auto largest = std::max_element(blocks_.begin(), blocks_.end(),
+                                            [](const Block& a, const Block& b) { return a.size < b.size; });
+            Block keep = std::move(*largest);
+            blocks_.clear();
+            blocks_.push_back(std::move(keep));
+            used_ = 0;
+        }
+    }
+
+private:
+    static constexpr std::size_t kBlockSize = 256 * 1024;
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        std::size_t size;
+    };
+    std::vector<Block> blocks_;
+    std::size_t used_ = 0;
+    std::size_t depth_ = 0;
+};
+
+// Marks arena memory in use on this thread; nests
+class ArenaScope {
+public:
+    ArenaScope() { ThreadArena::current().enter(); }
+    ~ArenaScope() { ThreadArena::current().leave(); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(ThreadArena::current().allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) {}
+    friend bool operator==(const ArenaAllocator&, const ArenaAllocator&) { return true; }
+    friend bool operator!=(const ArenaAllocator&, const ArenaAllocator&) { return false; }
+};
+
+// JSON type used only with sax_parse, so all parser scratch comes from the arena
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using ArenaJson = nlohmann::basic_json<std::map, std::vector, ArenaString, bool, std::int64_t,
+                                       std::uint64_t, double, ArenaAllocator>;
+
+// SAX handler that copies only the requested fields of each record.
+// Fields are dot-separated object key paths; values inside arrays are not
+// addressable. Buffers are reused across records, so steady-state parsing
+// does not allocate.
+class JsonFieldSelector {
+public:
+    explicit JsonFieldSelector(const std::vector<std::string>& paths) : fields_(paths.size()) {
+        for (const std::string& path : paths) {
+            std::vector<std::string> parts;
+            std::size_t start = 0;
+            for (std::size_t dot = path.find('.'); ; dot = path.find('.', start)) {
+                parts.push_back(path.substr(start, dot - start));
+                if (dot == std::string::npos) {
+                    break;
+                }
+                start = dot + 1;
+            }
+            maxDepth_ = std::max(maxDepth_, parts.size());
+            paths_.push_back(std::move(parts));
+        }
+    }
+
+    void reset() {
+        for (JsonField& field : fields_) {
+            field.type = JsonType::Missing;
+        }
+        depth_ = 0;
+        arrayDepth_ = 0;
+        frames_.clear();
+        error_.clear();
+    }
+
+    const std::vector<JsonField>& fields() const { return fields_; }
+    const std::string& error() const { return error_; }
+
+    bool null() {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::Null;
+        }
+        return true;
+    }
+    bool boolean(bool value) {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::Boolean;
+            field->boolean = value;
+        }
+        return true;
+    }
+    bool number_integer(std::int64_t value) {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::Integer;
+            field->integer = value;
+            field->number = static_cast<double>(value);
+        }
+        return true;
+    }
+    bool number_unsigned(std::uint64_t value) {
+        if (JsonField* field = selected()) {
+            const bool fits = value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+            field->type = fits ? JsonType::Integer : JsonType::Float;
+            field->integer = fits ? static_cast<std::int64_t>(value) : 0;
+            field->number = static_cast<double>(value);
+        }
+        return true;
+    }
+    template <typename String>
+    bool number_float(double value, const String&) {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::Float;
+            field->number = value;
+        }
+        return true;
+    }
+    template <typename String>
+    bool string(String& value) {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::String;
+            field->text.assign(value.data(), value.size());
+        }
+        return true;
+    }
+    template <typename Binary>
+    bool binary(Binary&) { return true; }
+    bool start_object(std::size_t) { return enter(false); }
+    bool start_array(std::size_t) { return enter(true); }
+    bool end_object() { return leave(); }
+    bool end_array() { return leave(); }
+    template <typename String>
+    bool key(String& key) {
+        if (arrayDepth_ == 0 && depth_ <= maxDepth_) {
+            if (keys_.size() < depth_) {
+                keys_.resize(depth_);
+            }
+            keys_[depth_ - 1].assign(key.data(), key.size());
+        }
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        error_ = e.what();
+        return false;
+    }
+
+private:
+    // Field addressed by the value about to be reported, if requested
+    JsonField* selected() {
+        if (depth_ == 0 || arrayDepth_ > 0 || depth_ > maxDepth_) {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < paths_.size(); ++i) {
+            const std::vector<std::string>& path = paths_[i];
+            if (path.size() == depth_ && std::equal(path.begin(), path.end(), keys_.begin())) {
+                return &fields_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    bool enter(bool array) {
+        if (JsonField* field = selected()) {
+            field->type = JsonType::Container;
+        }
+        frames_.push_back(array);
+        ++depth_;
+        arrayDepth_ += array ? 1 : 0;
+        return true;
+    }
+
+    bool leave() {
+        arrayDepth_ -= frames_.back() ? 1 : 0;
+        frames_.pop_back();
+        --depth_;
+        return true;
+    }
+
+    std::vector<std::vector<std::string>> paths_;
+    std::vector<JsonField> fields_;
+    std::vector<std::string> keys_;
+    std::vector<bool> frames_;
+    std::size_t maxDepth_ = 0;
+    std::size_t depth_ = 0;
+    std::size_t arrayDepth_ = 0;
+    std::string error_;
+};
+
+// Feeds NDJSON to a JsonFieldSelector one line at a time, parsing each
+// line in place. Input may arrive in arbitrary chunks; only a line split
+// across chunks is copied. Parser scratch lives in the thread's arena,
+// recycled after each line, so it is bounded by the longest record.
+// Readers working on pieces of one input share a stop flag so one visitor
+// returning false stops them all.
+class JsonLineReader {
+public:
+    JsonLineReader(const std::vector<std::string>& fields, const JsonRecordVisitor& visitor, JsonStreamResult& result,
+                   std::size_t firstLine = 0, std::atomic<bool>* stop = nullptr)
+        : selector_(fields), visitor_(visitor), result_(result), lineNumber_(firstLine), stop_(stop) {}
+
+    // False once the visitor asked to stop
+    bool feed(std::string_view chunk) {
+        while (!stopped() && !chunk.empty()) {
+            const char* newline = static_cast<const char*>(std::memchr(chunk.data(), '\n', chunk.size()));
+            if (!newline) {
+                carry_.append(chunk.data(), chunk.size());
+                break;
+            }
+            std::string_view line(chunk.data(), static_cast<std::size_t>(newline - chunk.data()));
+            chunk.remove_prefix(line.size() + 1);
+            if (carry_.empty()) {
+                parseLine(line);
+            } else {
+                carry_.append(line.data(), line.size());
+                parseLine(carry_);
+                carry_.clear();
+            }
+        }
+        return !stopped();
+    }
+
+    // Parses a final line with no trailing newline
+    void finish() {
+        if (!stopped() && !carry_.empty()) {
+            parseLine(carry_);
+            carry_.clear();
+        }
+    }
+
+    const std::string& firstError() const { return firstError_; }
+
+private:
+    bool stopped() const { return stopped_ || (stop_ && stop_->load(std::memory_order_relaxed)); }
+
+    void parseLine(std::string_view line) {
+        ++lineNumber_;
+        if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+            return;
+        }
+        ArenaScope scope;
+        selector_.reset();
+        if (!ArenaJson::sax_parse(line.data(), line.data() + line.size(), &selector_)) {
+            if (result_.errors++ == 0) {
+                firstError_ = "line " + std::to_string(lineNumber_) + ": " + selector_.error();
+            }
+            return;
+        }
+        ++result_.records;
+        if (visitor_ && !visitor_(lineNumber_, selector_.fields())) {
+            stopped_ = true;
+            if (stop_) {
+                stop_->store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    JsonFieldSelector selector_;
+    const JsonRecordVisitor& visitor_;
+    JsonStreamResult& result_;
+    std::string carry_;
+    std::string firstError_;
+    std::size_t lineNumber_;
+    std::atomic<bool>* stop_;
+    bool stopped_ = false;
+};
+
+enum class StatOp : std::size_t { Json, Hash, Compress, Regex, Database, Image, Text };
+constexpr std::size_t kStatOps = 7;
+constexpr const char* kStatOpNames[kStatOps] = {"json", "hash", "compress", "regex", "database", "image", "text"};
+
+// Per-operation call counts and latency histograms. Counters are spread
+// over cache-line-aligned shards picked per thread and updated with relaxed
+// atomics, so concurrent callers rarely touch the same line; readers sum
+// the shards. Latencies land in log-linear buckets, four per power of two
+// of nanoseconds, so reported percentiles are within about 12% of exact.
+// The processed-item and error totals are kept even when the per-operation
+// part is disabled; they cost two relaxed adds per call.
+class OperationStats {
+public:
+    explicit OperationStats(bool enabled)
+        : shards_(enabled ? std::make_unique<Shard[]>(kShards) : nullptr) {}
+
+    bool enabled() const { return shards_ != nullptr; }
+
+    void record(StatOp op, std::uint64_t nanos, std::uint64_t items, std::uint64_t errors) {
+        static thread_local const std::size_t shard = nextShard_.fetch_add(1, std::memory_order_relaxed) % kShards;
+        Counters& counters = shards_[shard].ops[static_cast<std::size_t>(op)];
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        counters.items.fetch_add(items, std::memory_order_relaxed);
+        if (errors > 0) {
+            counters.errors.fetch_add(errors, std::memory_order_relaxed);
+        }
+        counters.nanos.fetch_add(nanos, std::memory_order_relaxed);
+        counters.buckets[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Always maintained, whether or not record() is called
+    void count(std::uint64_t items, std::uint64_t errors) {
+        if (items > 0) {
+            totalItems_.fetch_add(items, std::memory_order_relaxed);
+        }
+        if (errors > 0) {
+            totalErrors_.fetch_add(errors, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t totalItems() const { return totalItems_.load(std::memory_order_relaxed); }
+    std::uint64_t totalErrors() const { return totalErrors_.load(std::memory_order_relaxed); }
+
+    json report() const {
+        json operations = json::object();
+        for (std::size_t op = 0; op < kStatOps && enabled(); ++op) {
+            std::uint64_t calls = 0, items = 0, errors = 0, nanos = 0;
+            std::array<std::uint64_t, kBuckets> buckets{};
+            for (std::size_t s = 0; s < kShards; ++s) {
+                const Counters& counters = shards_[s].ops[op];
+                calls += counters.calls.load(std::memory_order_relaxed);
+                items += counters.items.load(std::memory_order_relaxed);
+                errors += counters.errors.load(std::memory_order_relaxed);
+                nanos += counters.nanos.load(std::memory_order_relaxed);
+                for (std::size_t b = 0; b < kBuckets; ++b) {
+                    buckets[b] += counters.buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+            json latency;
+            latency["mean"] = calls > 0 ? static_cast<double>(nanos) / calls / 1000.0 : 0.0;
+            latency["p50"] = percentile(buckets, 0.50);
+            latency["p99"] = percentile(buckets, 0.99);
+            latency["p999"] = percentile(buckets, 0.999);
+            operations[kStatOpNames[op]] = {
+                {"calls", calls}, {"items", items}, {"errors", errors}, {"latency_us", latency}};
+        }
+        return operations;
+    }
+
+private:
+    static constexpr std::size_t kShards = 8;
+    // Buckets 0-3 hold 0-3 ns exactly; each later group of four splits one
+    // power of two. Anything past 2^40 ns (~18 minutes) shares the top bucket.
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr std::size_t kBuckets = (kMaxExponent - 1) * 4 + 4;
+
+    struct Counters {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> items{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::atomic<std::uint64_t> nanos{0};
+        std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};
+    };
+
+    struct alignas(64) Shard {
+        std::array<Counters, kStatOps> ops;
+    };
+
+    static std::size_t bucketFor(std::uint64_t nanos) {
+        if (nanos < 4) {
+            return static_cast<std::size_t>(nanos);
+        }
+        const unsigned exponent = std::min<unsigned>(63 - static_cast<unsigned>(__builtin_clzll(nanos)), kMaxExponent);
+        if (exponent == kMaxExponent) {
+            return kBuckets - 1;
+        }
+        return (exponent - 1) * 4 + static_cast<std::size_t>((nanos >> (exponent - 2)) & 3);
+    }
+
+    // Midpoint of the bucket holding the q-th quantile, in microseconds
+    static double percentile(const std::array<std::uint64_t, kBuckets>& buckets, double q) {
+        std::uint64_t count = 0;
+        for (std::uint64_t n : buckets) {
+            count += n;
+        }
+        if (count == 0) {
+            return 0.0;
+        }
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * count)));
+        std::uint64_t seen = 0;
+        std::size_t b = 0;
+        for (; b < kBuckets - 1; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) {
+                break;
+            }
+        }
+        if (b < 4) {
+            return b / 1000.0;
+        }
+        const unsigned exponent = static_cast<unsigned>(b / 4 + 1);
+        const double width = std::ldexp(1.0, static_cast<int>(exponent) - 2);
+        const double low = (4 + b % 4) * width;
+        return (low + width / 2) / 1000.0;
+    }
+
+    static inline std::atomic<std::size_t> nextShard_{0};
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<std::uint64_t> totalItems_{0};
+    std::atomic<std::uint64_t> totalErrors_{0};
+};
+
+// Times one call into OperationStats. With statistics disabled it does not
+// read the clock and only adds to the totals. A call counts as one item, or
+// none if it failed, unless items() says otherwise.
+class ScopedOp {
+public:
+    ScopedOp(OperationStats& stats, StatOp op) : stats_(stats), timed_(stats.enabled()), op_(op) {
+        if (timed_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedOp() {
+        const std::uint64_t items = itemsSet_ ? items_ : (errors_ > 0 ? 0 : 1);
+        stats_.count(items, errors_);
+        if (timed_) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+            stats_.record(op_, static_cast<std::uint64_t>(elapsed.count()), items, errors_);
+        }
+    }
+
+    ScopedOp(const ScopedOp&) = delete;
+    ScopedOp& operator=(const ScopedOp&) = delete;
+
+    void items(std::uint64_t count) {
+        items_ = count;
+        itemsSet_ = true;
+    }
+    void fail(std::uint64_t count = 1) { errors_ += count; }
+
+private:
+    OperationStats& stats_;
+    const bool timed_;
+    StatOp op_;
+    std::chrono::steady_clock::time_point start_;
+    std::uint64_t items_ = 0;
+    std::uint64_t errors_ = 0;
+    bool itemsSet_ = false;
+};
+
+// Lookup counters of one LruCache; each public stats type maps from these
+struct CacheCounters {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t entries = 0;
+};
+
+// Thread-safe LRU map from a string key to an immutable shared value.
+// Values are built outside the lock; a concurrent miss on the same key just
+// builds twice and the first insert wins.
+//
+// Each thread also remembers its recent lookups in a small direct-mapped
+// table, so repeated hits on a shared instance never touch the mutex. Those
+// entries are tagged with the cache's eviction epoch and go stale on any
+// eviction. Thread-local hits don't refresh LRU order; a pattern that is hot
+// only through them can be evicted and is then rebuilt once.
+template <typename T>
+class LruCache {
+public:
+    explicit LruCache(std::size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity), id_(nextId_.fetch_add(1, std::memory_order_relaxed) + 1) {}
+
+    template <typename Factory>
+    std::shared_ptr<const T> get(const std::string& key, Factory&& make) {
+        const std::size_t hash = std::hash<std::string>{}(key);
+        LocalSlot& slot = localSlots()[hash % kLocalSlots];
+        if (slot.owner == id_ && slot.epoch == epoch_.load(std::memory_order_acquire) && slot.key == key) {
+            localHits_.fetch_add(1, std::memory_order_relaxed);
+            return slot.value;
+        }
+        
+        std::shared_ptr<const T> value;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_++;
+                value = it->second->second;
+                remember(slot, key, value);
+                return value;
+            }
+        }
+        
+        value = make();
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        misses_++;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            value = it->second->second;
+        } else {
+            lru_.emplace_front(key, value);
+            index_.emplace(key, lru_.begin());
+            if (lru_.size() > capacity_) {
+                index_.erase(lru_.back().first);
+                lru_.pop_back();
+                epoch_.fetch_add(1, std::memory_order_release);
+            }
+        }
+        remember(slot, key, value);
+        return value;
+    }
+
+    CacheCounters counters() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CacheCounters result;
+        result.hits = hits_ + localHits_.load(std::memory_order_relaxed);
+        result.misses = misses_;
+        result.entries = lru_.size();
+        return result;
+    }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const T>>;
+    
+    struct LocalSlot {
+        std::uint64_t owner = 0;
+        std::uint64_t epoch = 0;
+        std::string key;
+        std::shared_ptr<const T> value;
+    };
+    
+    static constexpr std::size_t kLocalSlots = 32;
+    
+    // Shared by every cache of this value type; ids keep them apart, and a
+    // slot holds its value until a later lookup overwrites it
+    static std::array<LocalSlot, kLocalSlots>& localSlots() {
+        thread_local std::array<LocalSlot, kLocalSlots> slots;
+        return slots;
+    }
+    
+    // Called with mutex_ held, so the epoch can't move underneath
+    void remember(LocalSlot& slot, const std::string& key, const std::shared_ptr<const T>& value) {
+        slot.owner = id_;
+        slot.epoch = epoch_.load(std::memory_order_relaxed);
+        slot.key = key;
+        slot.value = value;
+    }
+
+    const std::size_t capacity_;
+    const std::uint64_t id_;
+    std::atomic<std::uint64_t> epoch_{0};
+    std::atomic<std::uint64_t> localHits_{0};
+    static std::atomic<std::uint64_t> nextId_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+template <typename T>
+std::atomic<std::uint64_t> LruCache<T>::nextId_{0};
+
+// RE2::Set compiled from a pattern list; invalidIndex names the first
+// pattern that failed to parse, or -1 when the set compiled.
+struct PatternSet {
+    explicit PatternSet(const std::vector<std::string>& patterns)
+        : set(RE2::DefaultOptions, RE2::UNANCHORED) {
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            if (set.Add(patterns[i], nullptr) < 0) {
+                invalidIndex = static_cast<int>(i);
+                return;
+            }
+        }
+        if (!set.Compile()) {
+            invalidIndex = static_cast<int>(patterns.size());
+        }
+    }
+
+    bool ok() const { return invalidIndex < 0; }
+
+    RE2::Set set;
+    int invalidIndex = -1;
+};
+
+// Compiled RE2 objects and pattern sets, keyed by pattern text and the
+// options that affect compilation. Patterns that fail to compile are cached
+// too, so callers see the error without paying for a recompile.
+class RegexCache {
+public:
+    explicit RegexCache(std::size_t capacity) : regexes_(capacity), sets_(capacity) {}
+
+    std::shared_ptr<const RE2> get(const std::string& pattern, const RE2::Options& options) {
+        return regexes_.get(makeKey(pattern, options), [&]() {
+            return std::make_shared<const RE2>(pattern, options);
+        });
+    }
+
+    std::shared_ptr<const PatternSet> getSet(const std::vector<std::string>& patterns) {
+        std::string key = std::to_string(patterns.size());
+        for (const auto& pattern : patterns) {
+            key += '\0';
+            key += pattern;
+        }
+        return sets_.get(key, [&]() { return std::make_shared<const PatternSet>(patterns); });
+    }
+
+    RegexCacheStats stats() const {
+        RegexCacheStats result;
+        for (const CacheCounters& counters : {regexes_.counters(), sets_.counters()}) {
+            result.hits += counters.hits;
+            result.misses += counters.misses;
+            result.entries += counters.entries;
+        }
+        return result;
+    }
+
+private:
+    // Built into a per-thread buffer so a cache hit doesn't allocate
+    static const std::string& makeKey(const std::string& pattern, const RE2::Options& options) {
+        thread_local std::string key;
+        key.clear();
+        fmt::format_to(std::back_inserter(key), "{}:{}:{}{}{}{}{}{}{}{}{}{}:",
+            static_cast<int>(options.encoding()), options.max_mem(),
+            options.posix_syntax(), options.longest_match(), options.literal(),
+            options.never_nl(), options.dot_nl(), options.never_capture(),
+            options.case_sensitive(), options.perl_classes(), options.word_boundary(),
+            options.one_line());
+        key += pattern;
+        return key;
+    }
+
+    LruCache<RE2> regexes_;
+    LruCache<PatternSet> sets_;
+};
+
+// Image pipeline: decode -> optional downscale -> encode, one row at a time.
+// Only interlaced PNGs are buffered whole, since libpng can't hand out a
+// finished row before the last pass.
+ImageFormat sniffImageFormat(std::FILE* file) {
+    unsigned char magic[8] = {};
+    const std::size_t got = std::fread(magic, 1, sizeof(magic), file);
+    std::rewind(file);
+    if (got >= 8 && png_sig_cmp(magic, 0, 8) == 0) {
+        return ImageFormat::Png;
+    }
+    if (got >= 3 && magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF) {
+        return ImageFormat::Jpeg;
+    }
+    return ImageFormat::Unknown;
+}
+
+ImageFormat formatFromExtension(const std::string& path) {
+    std::string ext = boost::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (ext == ".png") {
+        return ImageFormat::Png;
+    }
+    if (ext == ".jpg" || ext == ".jpeg") {
+        return ImageFormat::Jpeg;
+    }
+    return ImageFormat::Unknown;
+}
+
+using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE*)>;
+
+// libjpeg reports fatal errors through error_exit, which must not return.
+// We longjmp back to the setjmp in the reader/writer method that made the
+// call; those methods keep no locals with destructors.
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    std::jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    auto* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    std::longjmp(err->jump, 1);
+}
+
+// Corrupt-data warnings are not worth a log line per image
+void jpegSilence(j_common_ptr) {}
+
+class ImageReader {
+public:
+    virtual ~ImageReader() = default;
+    // Next row of width() * channels() bytes, top to bottom
+    virtual bool readRow(unsigned char* row) = 0;
+    // Consumes what follows the last row; reports truncation or trailing errors
+    virtual bool finish() = 0;
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const { return channels_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int width_ = 0;
+    int height_ = 0;
+    int channels_ = 0;
+    std::string error_;
+};
+
+class JpegReader : public ImageReader {
+public:
+    JpegReader() {
+        cinfo_.err = jpeg_std_error(&err_.base);
+        err_.base.error_exit = jpegErrorExit;
+        err_.base.output_message = jpegSilence;
+    }
+
+    ~JpegReader() override {
+        if (created_) {
+            jpeg_destroy_decompress(&cinfo_);
+        }
+    }
+
+    // With maxDimension set, the IDCT scales by the largest power of two
+    // (up to 1/8) that keeps the longer edge at or above it; those
+    // coefficients are never expanded, which is where thumbnails save time.
+    bool open(std::FILE* file, int maxDimension) {
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        jpeg_create_decompress(&cinfo_);
+        created_ = true;
+        jpeg_stdio_src(&cinfo_, file);
+        jpeg_read_header(&cinfo_, TRUE);
+        if (cinfo_.jpeg_color_space == JCS_CMYK || cinfo_.jpeg_color_space == JCS_YCCK) {
+            error_ = "CMYK JPEG is not supported";
+            return false;
+        }
+        cinfo_.out_color_space = cinfo_.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        if (maxDimension > 0) {
+            const unsigned int longest = std::max(cinfo_.image_width, cinfo_.image_height);
+            unsigned int denom = 1;
+            while (denom < 8 && longest / (denom * 2) >= static_cast<unsigned int>(maxDimension)) {
+                denom *= 2;
+            }
+            cinfo_.scale_num = 1;
+            cinfo_.scale_denom = denom;
+        }
+        jpeg_start_decompress(&cinfo_);
+        started_ = true;
+        width_ = static_cast<int>(cinfo_.output_width);
+        height_ = static_cast<int>(cinfo_.output_height);
+        channels_ = cinfo_.output_components;
+        return true;
+    }
+
+    bool readRow(unsigned char* row) override {
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        JSAMPROW rows[1] = {row};
+        return jpeg_read_scanlines(&cinfo_, rows, 1) == 1;
+    }
+
+    bool finish() override {
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        if (started_) {
+            jpeg_finish_decompress(&cinfo_);
+            started_ = false;
+        }
+        return true;
+    }
+
+private:
+    jpeg_decompress_struct cinfo_{};
+    JpegErrorManager err_{};
+    bool created_ = false;
+    bool started_ = false;
+};
+
+class PngReader : public ImageReader {
+public:
+    ~PngReader() override {
+        if (png_) {
+            png_destroy_read_struct(&png_, info_ ? &info_ : nullptr, nullptr);
+        }
+    }
+
+    // Palette, low-bit gray and tRNS are expanded and 16-bit samples
+    // stripped, so rows are always 8 bits per channel
+    bool open(std::FILE* file) {
+        png_ = png_create_read_struct(PNG_LIBPNG_VER_STRING, this, onError, onWarning);
+        info_ = png_ ? png_create_info_struct(png_) : nullptr;
+        if (!info_) {
+            error_ = "Failed to create PNG decoder";
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        png_init_io(png_, file);
+        png_read_info(png_, info_);
+        png_set_expand(png_);
+        png_set_strip_16(png_);
+        const bool interlaced = png_get_interlace_type(png_, info_) != PNG_INTERLACE_NONE;
+        if (interlaced) {
+            png_set_interlace_handling(png_);
+        }
+        png_read_update_info(png_, info_);
+        width_ = static_cast<int>(png_get_image_width(png_, info_));
+        height_ = static_cast<int>(png_get_image_height(png_, info_));
+        channels_ = png_get_channels(png_, info_);
+        
+        if (interlaced) {
+            const std::size_t stride = png_get_rowbytes(png_, info_);
+            whole_.resize(stride * static_cast<std::size_t>(height_));
+            rowPointers_.resize(static_cast<std::size_t>(height_));
+            for (int y = 0; y < height_; ++y) {
+                rowPointers_[static_cast<std::size_t>(y)] = whole_.data() + stride * static_cast<std::size_t>(y);
+            }
+            png_read_image(png_, rowPointers_.data());
+        }
+        return true;
+    }
+
+    bool readRow(unsigned char* row) override {
+        if (!rowPointers_.empty()) {
+            std::memcpy(row, rowPointers_[nextRow_++], static_cast<std::size_t>(width_) * channels_);
+            return true;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        png_read_row(png_, row, nullptr);
+        return true;
+    }
+
+    bool finish() override {
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        png_read_end(png_, nullptr);
+        return true;
+    }
+
+private:
+    static void onError(png_structp png, png_const_charp message) {
+        static_cast<PngReader*>(png_get_error_ptr(png))->error_ = message;
+        png_longjmp(png, 1);
+    }
+
+    static void onWarning(png_structp, png_const_charp) {}
+
+    png_structp png_ = nullptr;
+    png_infop info_ = nullptr;
+    std::vector<unsigned char> whole_;
+    std::vector<png_bytep> rowPointers_;
+    std::size_t nextRow_ = 0;
+};
+
+class ImageWriter {
+public:
+    virtual ~ImageWriter() = default;
+    virtual bool start(int width, int height, int channels) = 0;
+    virtual bool writeRow(const unsigned char* row) = 0;
+    virtual bool finish() = 0;
+
+    // Channels actually stored, after any conversion start() chose
+    int channels() const { return channels_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int channels_ = 0;
+    std::string error_;
+};
+
+class JpegWriter : public ImageWriter {
+public:
+    JpegWriter(std::FILE* file, int quality) : file_(file), quality_(std::clamp(quality, 1, 100)) {
+        cinfo_.err = jpeg_std_error(&err_.base);
+        err_.base.error_exit = jpegErrorExit;
+        err_.base.output_message = jpegSilence;
+    }
+
+    ~JpegWriter() override {
+        if (created_) {
+            jpeg_destroy_compress(&cinfo_);
+        }
+    }
+
+    bool start(int width, int height, int channels) override {
+        inputChannels_ = channels;
+        channels_ = channels <= 2 ? 1 : 3;
+        if (channels_ != channels) {
+            flattened_.resize(static_cast<std::size_t>(width) * channels_);
+        }
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        jpeg_create_compress(&cinfo_);
+        created_ = true;
+        jpeg_stdio_dest(&cinfo_, file_);
+        cinfo_.image_width = static_cast<JDIMENSION>(width);
+        cinfo_.image_height = static_cast<JDIMENSION>(height);
+        cinfo_.input_components = channels_;
+        cinfo_.in_color_space = channels_ == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_set_defaults(&cinfo_);
+        jpeg_set_quality(&cinfo_, quality_, TRUE);
+        jpeg_start_compress(&cinfo_, TRUE);
+        return true;
+    }
+
+    bool writeRow(const unsigned char* row) override {
+        if (flattened_.empty()) {
+            return writeScanline(row);
+        }
+        flattenAlpha(row);
+        return writeScanline(flattened_.data());
+    }
+
+    bool finish() override {
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        jpeg_finish_compress(&cinfo_);
+        return true;
+    }
+
+private:
+    bool writeScanline(const unsigned char* row) {
+        if (setjmp(err_.jump)) {
+            error_ = err_.message;
+            return false;
+        }
+        JSAMPROW rows[1] = {const_cast<JSAMPROW>(row)};
+        return jpeg_write_scanlines(&cinfo_, rows, 1) == 1;
+    }
+    
+    // JPEG has no alpha: composite onto white
+    void flattenAlpha(const unsigned char* row) {
+        const std::size_t pixels = flattened_.size() / static_cast<std::size_t>(channels_);
+        for (std::size_t x = 0; x < pixels; ++x) {
+            const unsigned char* in = row + x * static_cast<std::size_t>(inputChannels_);
+            const unsigned int alpha = in[inputChannels_ - 1];
+            for (int c = 0; c < channels_; ++c) {
+                flattened_[x * static_cast<std::size_t>(channels_) + c] =
+                    static_cast<unsigned char>((in[c] * alpha + 255u * (255u - alpha) + 127u) / 255u);
+            }
+        }
+    }
+
+    std::FILE* file_;
+    int quality_;
+    int inputChannels_ = 0;
+    std::vector<unsigned char> flattened_;
+    jpeg_compress_struct cinfo_{};
+    JpegErrorManager err_{};
+    bool created_ = false;
+};
+
+class PngWriter : public ImageWriter {
+public:
+    explicit PngWriter(std::FILE* file) : file_(file) {}
+
+    ~PngWriter() override {
+        if (png_) {
+            png_destroy_write_struct(&png_, info_ ? &info_ : nullptr);
+        }
+    }
+
+    bool start(int width, int height, int channels) override {
+        channels_ = channels;
+        png_ = png_create_write_struct(PNG_LIBPNG_VER_STRING, this, onError, nullptr);
+        info_ = png_ ? png_create_info_struct(png_) : nullptr;
+        if (!info_) {
+            error_ = "Failed to create PNG encoder";
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        static const int colorTypes[] = {PNG_COLOR_TYPE_GRAY, PNG_COLOR_TYPE_GRAY_ALPHA,
+                                         PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGB_ALPHA};
+        png_init_io(png_, file_);
+        png_set_IHDR(png_, info_, static_cast<png_uint_32>(width), static_cast<png_uint_32>(height), 8,
+                     colorTypes[channels - 1], PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_, info_);
+        return true;
+    }
+
+    bool writeRow(const unsigned char* row) override {
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        png_write_row(png_, row);
+        return true;
+    }
+
+    bool finish() override {
+        if (setjmp(png_jmpbuf(png_))) {
+            return false;
+        }
+        png_write_end(png_, nullptr);
+        return true;
+    }
+
+private:
+    static void onError(png_structp png, png_const_charp message) {
+        static_cast<PngWriter*>(png_get_error_ptr(png))->error_ = message;
+        png_longjmp(png, 1);
+    }
+
+    std::FILE* file_;
+    png_structp png_ = nullptr;
+    png_infop info_ = nullptr;
+};
+
+// Area-averaging downscaler fed one source row at a time: each output
+// pixel is the mean of the source pixels that map onto it. Holds one row
+// of column sums.
+class RowDownscaler {
+public:
+    RowDownscaler(int srcWidth, int srcHeight, int dstWidth, int dstHeight, int channels)
+        : srcHeight_(srcHeight), dstHeight_(dstHeight), channels_(channels),
+          columnOf_(static_cast<std::size_t>(srcWidth)), columnCount_(static_cast<std::size_t>(dstWidth)),
+          sums_(static_cast<std::size_t>(dstWidth) * channels), row_(sums_.size()) {
+        for (int x = 0; x < srcWidth; ++x) {
+            const auto column = static_cast<std::size_t>(static_cast<std::int64_t>(x) * dstWidth / srcWidth);
+            columnOf_[static_cast<std::size_t>(x)] = column;
+            columnCount_[column]++;
+        }
+    }
+
+    // Emits each output row as soon as its last source row has arrived
+    bool push(const unsigned char* src, const std::function<bool(const unsigned char*)>& emit) {
+        const int band = static_cast<int>(static_cast<std::int64_t>(srcRow_) * dstHeight_ / srcHeight_);
+        if (band != band_ && rowsInBand_ > 0 && !flush(emit)) {
+            return false;
+        }
+        band_ = band;
+        for (std::size_t x = 0; x < columnOf_.size(); ++x) {
+            std::uint64_t* sum = &sums_[columnOf_[x] * static_cast<std::size_t>(channels_)];
+            for (int c = 0; c < channels_; ++c) {
+                sum[c] += src[x * static_cast<std::size_t>(channels_) + c];
+            }
+        }
+        rowsInBand_++;
+        return ++srcRow_ < srcHeight_ || flush(emit);
+    }
+
+private:
+    bool flush(const std::function<bool(const unsigned char*)>& emit) {
+        for (std::size_t column = 0; column < columnCount_.size(); ++column) {
+            const std::uint64_t count = static_cast<std::uint64_t>(columnCount_[column]) * rowsInBand_;
+            for (int c = 0; c < channels_; ++c) {
+                const std::size_t i = column * static_cast<std::size_t>(channels_) + c;
+                row_[i] = static_cast<unsigned char>(count ? (sums_[i] + count / 2) / count : 0);
+            }
+        }
+        std::fill(sums_.begin(), sums_.end(), 0);
+        rowsInBand_ = 0;
+        return emit(row_.data());
+    }
+
+    const int srcHeight_;
+    const int dstHeight_;
+    const int channels_;
+    std::vector<std::size_t> columnOf_;
+    std::vector<std::uint32_t> columnCount_;
+    std::vector<std::uint64_t> sums_;
+    std::vector<unsigned char> row_;
+    int srcRow_ = 0;
+    int band_ = 0;
+    std::uint32_t rowsInBand_ = 0;
+};
+
+// Streams inputPath through the pipeline into outputPath, or only decodes
+// it when outputPath is empty. info receives the source image's layout.
+ImageResult transcodeImage(const std::string& inputPath, const std::string& outputPath,
+                           const ImageOptions& options, ImageInfo* info) {
+    ImageResult result;
+    FilePtr input(std::fopen(inputPath.c_str(), "rb"), std::fclose);
+    if (!input) {
+        result.error = "Failed to open image: " + inputPath;
+        return result;
+    }
+    
+    const ImageFormat sourceFormat = sniffImageFormat(input.get());
+    std::unique_ptr<ImageReader> reader;
+    if (sourceFormat == ImageFormat::Jpeg) {
+        auto jpeg = std::make_unique<JpegReader>();
+        if (jpeg->open(input.get(), outputPath.empty() ? 0 : options.maxDimension)) {
+            reader = std::move(jpeg);
+        } else {
+            result.error = jpeg->error();
+        }
+    } else if (sourceFormat == ImageFormat::Png) {
+        auto png = std::make_unique<PngReader>();
+        if (png->open(input.get())) {
+            reader = std::move(png);
+        } else {
+            result.error = png->error();
+        }
+    } else {
+        result.error = "Unsupported image format";
+    }
+    if (!reader) {
+        result.error = inputPath + ": " + result.error;
+        return result;
+    }
+    if (info) {
+        *info = ImageInfo{sourceFormat, reader->width(), reader->height(), reader->channels()};
+    }
+    
+    std::vector<unsigned char> row(static_cast<std::size_t>(reader->width()) * reader->channels());
+    if (outputPath.empty()) {
+        for (int y = 0; y < reader->height(); ++y) {
+            if (!reader->readRow(row.data())) {
+                result.error = inputPath + ": " + reader->error();
+                return result;
+            }
+        }
+        if (!reader->finish()) {
+            result.error = inputPath + ": " + reader->error();
+            return result;
+        }
+        result.ok = true;
+        result.output = ImageInfo{sourceFormat, reader->width(), reader->height(), reader->channels()};
+        return result;
+    }
+    
+    ImageFormat targetFormat = options.format;
+    if (targetFormat == ImageFormat::Unknown) {
+        targetFormat = formatFromExtension(outputPath);
+    }
+    if (targetFormat == ImageFormat::Unknown) {
+        targetFormat = sourceFormat;
+    }
+    
+    int width = reader->width();
+    int height = reader->height();
+    const int longest = std::max(width, height);
+    if (options.maxDimension > 0 && longest > options.maxDimension) {
+        const double scale = static_cast<double>(options.maxDimension) / longest;
+        width = std::max(1, static_cast<int>(std::lround(width * scale)));
+        height = std::max(1, static_cast<int>(std::lround(height * scale)));
+    }
+    
+    FilePtr output(std::fopen(outputPath.c_str(), "wb"), std::fclose);
+    if (!output) {
+        result.error = "Failed to open file for writing: " + outputPath;
+        return result;
+    }
+    std::unique_ptr<ImageWriter> writer;
+    if (targetFormat == ImageFormat::Jpeg) {
+        writer = std::make_unique<JpegWriter>(output.get(), options.quality);
+    } else {
+        writer = std::make_unique<PngWriter>(output.get());
+    }
+    
+    auto write = [&writer](const unsigned char* out) { return writer->writeRow(out); };
+    bool ok = writer->start(width, height, reader->channels());
+    if (width == reader->width() && height == reader->height()) {
+        for (int y = 0; ok && y < reader->height(); ++y) {
+            ok = reader->readRow(row.data()) && write(row.data());
+        }
+    } else {
+        RowDownscaler scaler(reader->width(), reader->height(), width, height, reader->channels());
+        for (int y = 0; ok && y < reader->height(); ++y) {
+            ok = reader->readRow(row.data()) && scaler.push(row.data(), write);
+        }
+    }
+    ok = ok && reader->finish() && writer->finish();
+    const int storedChannels = writer->channels();
+    const std::string error = !reader->error().empty() ? reader->error() : writer->error();
+    writer.reset();
+    ok = std::fclose(output.release()) == 0 && ok;
+    
+    if (!ok) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(outputPath, ec);
+        result.error = fmt::format("{} -> {}: {}", inputPath, outputPath, error.empty() ? "write failed" : error);
+        return result;
+    }
+    result.ok = true;
+    result.output = ImageInfo{targetFormat, width, height, storedChannels};
+    return result;
+}
+
+// Glyph coverage bitmaps for one face, shelf-packed into 8-bit pages and
+// keyed by glyph index and pixel size. When every page is full the atlas
+// starts over instead of tracking per-glyph recency. Guarded by the owning
+// FontFace's mutex.
+class GlyphAtlas {
+public:
+    static constexpr int kPageSize = 512;
+    static constexpr std::size_t kMaxPages = 8;
+
+    struct Glyph {
+        std::size_t page = 0;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        // Bitmap origin relative to the pen position, y up
+        int left = 0;
+        int top = 0;
+    };
+
+    const Glyph* find(std::uint32_t glyph, int pixelSize) {
+        auto it = glyphs_.find(key(glyph, pixelSize));
+        if (it == glyphs_.end()) {
+            misses_++;
+            return nullptr;
+        }
+        hits_++;
+        return &it->second;
+    }
+
+    // Copies the bitmap just rendered into slot; nullptr if it is larger
+    // than a page, in which case the caller draws from the slot directly
+    const Glyph* insert(std::uint32_t glyph, int pixelSize, FT_GlyphSlot slot) {
+        const FT_Bitmap& bitmap = slot->bitmap;
+        const int width = static_cast<int>(bitmap.width);
+        const int height = static_cast<int>(bitmap.rows);
+        if (width + 1 > kPageSize || height + 1 > kPageSize) {
+            return nullptr;
+        }
+        if (pages_.empty() || shelfX_ + width + 1 > kPageSize) {
+            shelfX_ = 0;
+            shelfY_ += shelfHeight_;
+            shelfHeight_ = 0;
+        }
+        if (pages_.empty() || shelfY_ + height + 1 > kPageSize) {
+            if (pages_.size() == kMaxPages) {
+                pages_.clear();
+                glyphs_.clear();
+            }
+            pages_.emplace_back(static_cast<std::size_t>(kPageSize) * kPageSize, 0);
+            shelfX_ = 0;
+            shelfY_ = 0;
+            shelfHeight_ = 0;
+        }
+        
+        Glyph placed;
+        placed.page = pages_.size() - 1;
+        placed.x = shelfX_;
+        placed.y = shelfY_;
+        placed.width = width;
+        placed.height = height;
+        placed.left = slot->bitmap_left;
+        placed.top = slot->bitmap_top;
+        unsigned char* page = pages_.back().data();
+        for (int row = 0; row < height; ++row) {
+            copyCoverage(bitmap, row, page + static_cast<std::size_t>(placed.y + row) * kPageSize + placed.x);
+        }
+        shelfX_ += width + 1;
+        shelfHeight_ = std::max(shelfHeight_, height + 1);
+        return &glyphs_.emplace(key(glyph, pixelSize), placed).first->second;
+    }
+
+    const unsigned char* page(std::size_t index) const {
+        return pages_[index].data();
+    }
+
+    std::size_t pageCount() const { return pages_.size(); }
+    std::uint64_t hits() const { return hits_; }
+    std::uint64_t misses() const { return misses_; }
+
+    // One row of an 8-bit gray or 1-bit mono bitmap as 0-255 coverage.
+    // Negative pitch means the rows are stored bottom-up.
+    static void copyCoverage(const FT_Bitmap& bitmap, int row, unsigned char* out) {
+        const unsigned char* src = bitmap.buffer;
+        if (bitmap.pitch < 0) {
+            src -= static_cast<std::ptrdiff_t>(bitmap.pitch) * (static_cast<int>(bitmap.rows) - 1);
+        }
+        src += static_cast<std::ptrdiff_t>(bitmap.pitch) * row;
+        if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+            for (unsigned int x = 0; x < bitmap.width; ++x) {
+                out[x] = (src[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
+            }
+        } else {
+            std::memcpy(out, src, bitmap.width);
+        }
+    }
+
+private:
+    static std::uint64_t key(std::uint32_t glyph, int pixelSize) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(pixelSize)) << 32) | glyph;
+    }
+
+    std::vector<std::vector<unsigned char>> pages_;
+    std::unordered_map<std::uint64_t, Glyph> glyphs_;
+    int shelfX_ = 0;
+    int shelfY_ = 0;
+    int shelfHeight_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+// One shaped line: glyph indices and positions in 26.6 fixed point, plus
+// the line metrics at the size it was shaped for.
+struct ShapedRun {
+    struct Placement {
+        std::uint32_t glyph;
+        std::int32_t xAdvance;
+        std::int32_t xOffset;
+        std::int32_t yOffset;
+    };
+    std::vector<Placement> glyphs;
+    std::int64_t advance = 0;
+    // Pixels above and below the baseline
+    int ascender = 0;
+    int descender = 0;
+};
+
+// An opened font file: the FreeType face, the HarfBuzz font over it and
+// the glyph atlas. FT_Face and its glyph slot are not thread-safe, so every
+// use after open() holds mutex.
+class FontFace {
+public:
+    static std::shared_ptr<FontFace> open(FreeTypeLibrary& library, const std::string& path, std::string& error) {
+        auto face = std::shared_ptr<FontFace>(new FontFace(library));
+        std::lock_guard<std::mutex> lock(library.mutex);
+        if (FT_New_Face(library.library, path.c_str(), 0, &face->face_) != 0) {
+            face->face_ = nullptr;
+            error = "Failed to open font: " + path;
+            return nullptr;
+        }
+        face->font_ = hb_ft_font_create_referenced(face->face_);
+        if (!face->font_) {
+            error = "Failed to create HarfBuzz font: " + path;
+            return nullptr;
+        }
+        return face;
+    }
+
+    ~FontFace() {
+        if (font_) {
+            hb_font_destroy(font_);
+        }
+        if (face_) {
+            std::lock_guard<std::mutex> lock(library_.mutex);
+            FT_Done_Face(face_);
+        }
+    }
+
+    FontFace(const FontFace&) = delete;
+    FontFace& operator=(const FontFace&) = delete;
+
+    bool setPixelSize(int pixelSize) {
+        if (pixelSize == pixelSize_) {
+            return true;
+        }
+        if (FT_Set_Pixel_Sizes(face_, 0, static_cast<FT_UInt>(pixelSize)) != 0) {
+            return false;
+        }
+        hb_ft_font_changed(font_);
+        pixelSize_ = pixelSize;
+        return true;
+    }
+
+    // Requires setPixelSize to have succeeded
+    ShapedRun shape(const std::string& text) {
+        struct BufferDeleter {
+            void operator()(hb_buffer_t* buffer) const { hb_buffer_destroy(buffer); }
+        };
+        thread_local std::unique_ptr<hb_buffer_t, BufferDeleter> buffer(hb_buffer_create());
+        
+        hb_buffer_clear_contents(buffer.get());
+        hb_buffer_add_utf8(buffer.get(), text.data(), static_cast<int>(text.size()), 0,
+                           static_cast<int>(text.size()));
+        hb_buffer_guess_segment_properties(buffer.get());
+        hb_shape(font_, buffer.get(), nullptr, 0);
+        
+        unsigned int count = 0;
+        const hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(buffer.get(), &count);
+        const hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(buffer.get(), &count);
+        ShapedRun run;
+        run.glyphs.reserve(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            run.glyphs.push_back({infos[i].codepoint, positions[i].x_advance, positions[i].x_offset,
+                                  positions[i].y_offset});
+            run.advance += positions[i].x_advance;
+        }
+        const FT_Size_Metrics& metrics = face_->size->metrics;
+        run.ascender = static_cast<int>((metrics.ascender + 63) >> 6);
+        run.descender = static_cast<int>((-metrics.descender + 63) >> 6);
+        return run;
+    }
+
+    // Atlas entry for the glyph at the current size, rasterizing on a miss.
+    // nullptr means it failed to load (failed is set) or is too large for
+    // the atlas, in which case rendered() still holds its bitmap.
+    const GlyphAtlas::Glyph* glyph(std::uint32_t index, bool& failed) {
+        failed = false;
+        if (const GlyphAtlas::Glyph* cached = atlas_.find(index, pixelSize_)) {
+            return cached;
+        }
+        if (FT_Load_Glyph(face_, index, FT_LOAD_RENDER) != 0) {
+            failed = true;
+            return nullptr;
+        }
+        return atlas_.insert(index, pixelSize_, face_->glyph);
+    }
+
+    FT_GlyphSlot rendered() const { return face_->glyph; }
+    const GlyphAtlas& atlas() const { return atlas_; }
+
+    std::mutex mutex;
+
+private:
+    explicit FontFace(FreeTypeLibrary& library) : library_(library) {}
+
+    FreeTypeLibrary& library_;
+    FT_Face face_ = nullptr;
+    hb_font_t* font_ = nullptr;
+    int pixelSize_ = 0;
+    GlyphAtlas atlas_;
+};
+
+// Pixel extent of a shaped run once padded; at least 1x1
+std::pair<int, int> textExtent(const ShapedRun& run, int padding) {
+    const int width = static_cast<int>((run.advance + 63) >> 6) + 2 * padding;
+    const int height = run.ascender + run.descender + 2 * padding;
+    return {std::max(width, 1), std::max(height, 1)};
+}
+
+} // namespace
+
+// PIMPL implementation
+class DataProcessor::Impl {
+public:
+    explicit Impl(const DataProcessorOptions& options)
+        : logger_(nullptr), db_(nullptr), features_(options.features),
+          regexCache_(options.regexCacheCapacity), shapeCache_(options.shapeCacheCapacity), httpOptions_(options.http),
+          stats_(options.collectStats), loggingOptions_(options.logging),
+          pool_(options.workerThreads, options.maxQueuedTasks) {
+        initializeComponents();
+    }
+    
+    ~Impl() {
+        // Drain callers' async work first, then anything queued internally
+        waitForCompletion();
+        pool_.waitIdle();
+        cleanupComponents();
+    }
+    
+    // JSON Processing
+    // Validated with the SAX parser; no DOM is built just to count elements
+    bool processJsonData(std::string_view jsonData) {
+        ScopedOp op(stats_, StatOp::Json);
+        JsonElementCounter counter;
+        if (!json::sax_parse(jsonData.data(), jsonData.data() + jsonData.size(), &counter)) {
+            op.fail();
+            logger_->error("JSON parsing error: {}", counter.error());
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully parsed JSON data with {} elements", counter.count());
+        return true;
+    }
+    
+    bool processJsonLines(std::string_view data, const std::vector<std::string>& fields,
+                          const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+        ScopedOp op(stats_, StatOp::Json);
+        result = JsonStreamResult{};
+        JsonLineReader reader(fields, visitor, result);
+        if (reader.feed(data)) {
+            reader.finish();
+        }
+        return finishJsonLines(op, reader.firstError(), result, "buffer");
+    }
+    
+    // A non-empty encoding converts the file to UTF-8 chunk by chunk on
+    // its way to the parser
+    bool processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                         const JsonRecordVisitor& visitor, JsonStreamResult& result, const std::string& encoding) {
+        ScopedOp op(stats_, StatOp::Json);
+        result = JsonStreamResult{};
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            op.fail();
+            logger_->error("Failed to open JSON file: {}", path);
+            return false;
+        }
+        std::unique_ptr<EncodingConverter> converter;
+        if (!encoding.empty()) {
+            converter = std::make_unique<EncodingConverter>(encoding, "UTF-8");
+        }
+        
+        JsonLineReader reader(fields, visitor, result);
+        ReadAhead chunks(input, pool_.onWorkerThread() ? nullptr : &pool_, kJsonReadSize);
+        std::string converted;
+        bool more = true;
+        bool decoded = !converter || converter->ok();
+        for (std::string_view chunk = chunks.next(); decoded && more && !chunk.empty(); chunk = chunks.next()) {
+            if (converter && !converter->passesThrough(chunk)) {
+                converted.clear();
+                decoded = converter->feed(chunk, converted);
+                chunk = converted;
+            }
+            more = decoded && reader.feed(chunk);
+        }
+        if (decoded && more && converter) {
+            converted.clear();
+            decoded = converter->finish(converted);
+            more = decoded && reader.feed(converted);
+        }
+        if (more) {
+            reader.finish();
+        }
+        if (chunks.failed() || !decoded) {
+            op.fail();
+            logger_->error("Failed to read JSON file: {}{}", path,
+                           decoded ? std::string() : ": " + converter->error());
+            return false;
+        }
+        return finishJsonLines(op, reader.firstError(), result, path);
+    }
+    
+    // Parallel NDJSON: the buffer is cut into pieces ending on a newline.
+    // Pieces are pre-scanned for their line counts, so visitors see true
+    // line numbers, then parsed concurrently on the pool.
+    bool processJsonBatch(std::string_view data, const std::vector<std::string>& fields,
+                          const JsonRecordVisitor& visitor, JsonStreamResult& result, const std::string& source) {
+        ScopedOp op(stats_, StatOp::Json);
+        result = JsonStreamResult{};
+        const std::size_t target = std::min(std::max(data.size() / (4 * pool_.threadCount()), kJsonBatchMinPiece),
+                                            kJsonBatchMaxPiece);
+        std::vector<std::string_view> pieces;
+        for (std::size_t start = 0; start < data.size();) {
+            std::size_t end = std::min(start + target, data.size());
+            if (end < data.size()) {
+                const void* newline = std::memchr(data.data() + end, '\n', data.size() - end);
+                end = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - data.data()) + 1 : data.size();
+            }
+            pieces.push_back(data.substr(start, end - start));
+            start = end;
+        }
+        
+        // Waiting on piece tasks from a pool thread could starve the pool
+        if (pieces.size() <= 1 || pool_.onWorkerThread()) {
+            JsonLineReader reader(fields, visitor, result);
+            bool more = true;
+            for (std::size_t i = 0; more && i < pieces.size(); ++i) {
+                more = reader.feed(pieces[i]);
+            }
+            if (more) {
+                reader.finish();
+            }
+            return finishJsonLines(op, reader.firstError(), result, source);
+        }
+        
+        std::vector<std::future<std::size_t>> lineCounts;
+        for (std::string_view piece : pieces) {
+            lineCounts.push_back(pool_.submit([piece]() {
+                return static_cast<std::size_t>(std::count(piece.begin(), piece.end(), '\n'));
+            }));
+        }
+        
+        struct PieceResult {
+            JsonStreamResult counts;
+            std::string firstError;
+        };
+        std::atomic<bool> stop{false};
+        std::vector<std::future<PieceResult>> parsed;
+        std::size_t firstLine = 0;
+        for (std::size_t i = 0; i < pieces.size(); ++i) {
+            std::string_view piece = pieces[i];
+            parsed.push_back(pool_.submit([&fields, &visitor, &stop, piece, firstLine]() {
+                PieceResult pieceResult;
+                JsonLineReader reader(fields, visitor, pieceResult.counts, firstLine, &stop);
+                if (reader.feed(piece)) {
+                    reader.finish();
+                }
+                pieceResult.firstError = reader.firstError();
+                return pieceResult;
+            }));
+            firstLine += lineCounts[i].get();
+        }
+        
+        // Every task references the caller's fields and visitor; collect
+        // them all before rethrowing a visitor exception
+        std::string firstError;
+        std::exception_ptr failure;
+        for (auto& future : parsed) {
+            try {
+                PieceResult piece = future.get();
+                result.records += piece.counts.records;
+                result.errors += piece.counts.errors;
+                if (firstError.empty()) {
+                    firstError = std::move(piece.firstError);
+                }
+            } catch (...) {
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        return finishJsonLines(op, firstError, result, source);
+    }
+    
+    bool processJsonBatchFile(const std::string& path, const std::vector<std::string>& fields,
+                              const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+        result = JsonStreamResult{};
+        MappedBuffer mapped(path);
+        if (!mapped.ok()) {
+            logger_->error("Failed to map JSON file: {}", path);
+            return false;
+        }
+        return processJsonBatch(mapped.view(), fields, visitor, result, path);
+    }
+    
+    std::string generateJsonReport() const {
+        json report;
+        report["timestamp"] = pt::to_iso_string(pt::second_clock::universal_time());
+        report["status"] = "success";
+        report["processed_items"] = stats_.totalItems();
+        report["errors"] = stats_.totalErrors();
+        report["stats_enabled"] = stats_.enabled();
+        if (stats_.enabled()) {
+            report["operations"] = stats_.report();
+        }
+        if (logPool_) {
+            // Overruns count records dropped from the ring, by every
+            // processor sharing it
+            report["logging"] = {
+                {"queue_size", std::max<std::size_t>(loggingOptions_.queueSize, 1)},
+                {"overruns", logPool_->overrun_counter()},
+            };
+        }
+        std::lock_guard<std::mutex> lock(batchMutex_);
+        if (lastBatch_) {
+            report["batch"] = batchReportJson(*lastBatch_);
+        }
+        return report.dump(2);
+    }
+    
+    // File System Operations
+    bool processFilesInDirectory(const std::string& directoryPath, const FileVisitor& visitor) {
+        fs::path dir(directoryPath);
+        boost::system::error_code ec;
+        if (!fs::is_directory(dir, ec)) {
+            logger_->error("Directory does not exist: {}", directoryPath);
+            return false;
+        }
+        
+        auto scan = std::make_shared<DirectoryScan>(visitor);
+        if (pool_.onWorkerThread()) {
+            // Blocking a worker on its own subtasks could starve the pool
+            scanDirectory(scan, dir, false);
+        } else {
+            scan->enter();
+            pool_.submit([this, scan, dir]() { scanDirectory(scan, dir, true); });
+            scan->wait();
+        }
+        
+        for (const auto& error : scan->errors) {
+            logger_->error("Directory scan error: {}", error);
+        }
+        logger_->info("Processed {} files in {} directories: {}", scan->files.load(), scan->directories.load(), directoryPath);
+        return scan->errors.empty();
+    }
+    
+    // Incremental index: files whose size and mtime match their file_index
+    // row keep the stored hash; only new or changed files are rehashed.
+    bool indexDirectory(const std::string& directoryPath, IndexScanResult& result) {
+        result = IndexScanResult{};
+        if (!db_) {
+            logger_->error("Database not initialized");
+            return false;
+        }
+        
+        // Rows under this root, loaded once so the scan runs without the database lock
+        std::unordered_map<std::string, IndexedFile> known;
+        const std::string prefix = (fs::path(directoryPath) / "").string();
+        std::string upper = prefix;
+        upper.back() = static_cast<char>(upper.back() + 1);
+        bool loaded = queryData("SELECT path, size, mtime FROM file_index WHERE path >= ?1 AND path < ?2",
+                                {prefix, upper}, [&known](const QueryRow& row) {
+            known.emplace(std::piecewise_construct,
+                          std::forward_as_tuple(row.column(0)),
+                          std::forward_as_tuple(row.columnInt(1), row.columnInt(2)));
+            return true;
+        }, QueryOptions{});
+        if (!loaded) {
+            logger_->error("File index not available; enable DatabaseOptions::fileIndex");
+            return false;
+        }
+        
+        std::mutex updatesMutex;
+        std::vector<IndexUpdate> updates;
+        std::atomic<std::size_t> unchanged{0};
+        bool scanned = processFilesInDirectory(directoryPath, [&](const std::string& path) {
+            std::int64_t size = 0;
+            std::int64_t mtime = 0;
+            if (const boost::system::error_code statError = statForIndex(path, size, mtime)) {
+                throw fs::filesystem_error("stat", path, statError);
+            }
+            
+            auto it = known.find(path);
+            if (it != known.end()) {
+                it->second.seen.store(true, std::memory_order_relaxed);
+                if (it->second.size == size && it->second.mtime == mtime) {
+                    unchanged++;
+                    return;
+                }
+            }
+            
+            std::string hash = hashFile(path);
+            if (hash.empty()) {
+                throw std::runtime_error("failed to hash file");
+            }
+            std::lock_guard<std::mutex> lock(updatesMutex);
+            updates.push_back({path, size, mtime, std::move(hash), it == known.end()});
+        });
+        
+        std::vector<std::string> removed;
+        for (const auto& entry : known) {
+            if (!entry.second.seen.load(std::memory_order_relaxed)) {
+                removed.push_back(entry.first);
+            }
+        }
+        // A failed scan may have missed files, so never prune on one
+        if (!scanned) {
+            removed.clear();
+        }
+        
+        if (!writeIndexUpdates(updates, removed)) {
+            return false;
+        }
+        
+        result.unchanged = unchanged;
+        result.removed = removed.size();
+        for (const auto& update : updates) {
+            (update.added ? result.added : result.changed)++;
+        }
+        result.files = result.unchanged + result.added + result.changed;
+        
+        logger_->info("Indexed {}: {} added, {} changed, {} removed, {} unchanged", directoryPath,
+                      result.added, result.changed, result.removed, result.unchanged);
+        return scanned;
+    }
+    
+    // Batch pipeline: one thread per stage, connected by StageQueues. The
+    // CPU-bound stages hand each file to the worker pool and keep a window
+    // of results in flight, forwarding them in scan order; pool tasks never
+    // block on a queue, so the pipeline can't starve a small pool.
+    BatchReport runBatch(const BatchJob& job) {
+        BatchReport report;
+        const auto started = std::chrono::steady_clock::now();
+        boost::system::error_code ec;
+        if (!fs::is_directory(job.inputDirectory, ec)) {
+            report.firstError = "Not a directory: " + job.inputDirectory;
+            logger_->error("Batch failed: {}", report.firstError);
+            return report;
+        }
+        fs::create_directories(job.outputDirectory, ec);
+        if (ec) {
+            report.firstError = "Failed to create output directory: " + job.outputDirectory;
+            logger_->error("Batch failed: {}", report.firstError);
+            return report;
+        }
+        if (job.storeIndex && !db_) {
+            report.firstError = "Database not initialized";
+            logger_->error("Batch failed: {}", report.firstError);
+            return report;
+        }
+        if (job.session && !job.session->ok()) {
+            report.firstError = "Invalid cipher session";
+            logger_->error("Batch failed: {}", report.firstError);
+            return report;
+        }
+        
+        using Item = std::shared_ptr<BatchItem>;
+        using Queue = StageQueue<Item>;
+        static const char* const names[] = {"scan", "read", "hash", "compress", "encrypt", "store"};
+        constexpr std::size_t kStages = 6;
+        std::array<BatchStageCounters, kStages> counters;
+        // queues[i] feeds stage i + 1
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (std::size_t i = 0; i + 1 < kStages; ++i) {
+            queues.push_back(std::make_unique<Queue>(job.queueCapacity));
+        }
+        
+        auto timed = [](BatchStageCounters& stage, const auto& work) {
+            const auto start = std::chrono::steady_clock::now();
+            work();
+            stage.busyNanos.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+        };
+        auto fail = [](BatchItem& item, std::string error) {
+            if (item.error.empty()) {
+                item.error = std::move(error);
+            }
+        };
+        
+        const fs::path outputRoot = fs::absolute(job.outputDirectory);
+        auto scan = [&]() {
+            BatchStageCounters& stage = counters[0];
+            fs::recursive_directory_iterator it(job.inputDirectory, ec);
+            for (const fs::recursive_directory_iterator end; !ec && it != end; it.increment(ec)) {
+                auto item = std::make_shared<BatchItem>();
+                bool regular = false;
+                timed(stage, [&]() {
+                    boost::system::error_code statError;
+                    if (fs::is_directory(it->status(statError))) {
+                        if (fs::equivalent(it->path(), outputRoot, statError)) {
+                            it.disable_recursion_pending();
+                        }
+                        return;
+                    }
+                    if (!fs::is_regular_file(it->status(statError))) {
+                        return;
+                    }
+                    regular = true;
+                    item->path = it->path().string();
+                    item->relative = it->path().lexically_relative(job.inputDirectory).string();
+                    statError = statForIndex(item->path, item->size, item->mtime);
+                    if (statError) {
+                        fail(*item, "stat " + item->path + ": " + statError.message());
+                    }
+                });
+                if (regular) {
+                    stage.items++;
+                    stage.bytes += static_cast<std::uint64_t>(item->size);
+                    stage.outputWaitNanos += queues[0]->push(std::move(item));
+                }
+            }
+            if (ec) {
+                std::lock_guard<std::mutex> lock(batchMutex_);
+                report.firstError = "Failed to scan " + job.inputDirectory + ": " + ec.message();
+            }
+        };
+        
+        // Per-file work for stages 1-5 (read .. store)
+        std::vector<IndexUpdate> pendingIndex;
+        std::uint64_t bytesOut = 0;
+        const std::array<std::function<void(BatchItem&)>, kStages> work = {
+            nullptr,
+            [&](BatchItem& item) {
+                item.data = MappedBuffer(item.path);
+                if (!item.data.ok()) {
+                    fail(item, "Failed to map " + item.path);
+                }
+            },
+            [&](BatchItem& item) {
+                Sha256Digest digest;
+                if (!hashOnThreadContext(item.data.view(), digest)) {
+                    fail(item, "Failed to hash " + item.path);
+                    return;
+                }
+                Sha256Hex hex = Hasher::toHex(digest);
+                item.hash.assign(hex.data(), hex.size());
+            },
+            [&](BatchItem& item) {
+                if (!compress(item.data.view(), item.payload, job.level)) {
+                    fail(item, "Failed to compress " + item.path);
+                }
+                // Release the mapping as soon as the bytes are consumed
+                item.data = MappedBuffer();
+            },
+            [&](BatchItem& item) {
+                if (!job.session) {
+                    return;
+                }
+                std::string sealed(CipherSession::sealedSize(item.payload.size()), '\0');
+                std::size_t written = 0;
+                if (!job.session->seal(item.payload, &sealed[0], sealed.size(), written)) {
+                    fail(item, "Failed to encrypt " + item.path);
+                    return;
+                }
+                sealed.resize(written);
+                item.payload.swap(sealed);
+            },
+            [&](BatchItem& item) {
+                const fs::path target = outputRoot / (item.relative + (job.session ? ".sealed" : ".z"));
+                boost::system::error_code dirError;
+                fs::create_directories(target.parent_path(), dirError);
+                std::ofstream output(target.string(), std::ios::binary);
+                output.write(item.payload.data(), static_cast<std::streamsize>(item.payload.size()));
+                output.close();
+                if (!output) {
+                    fail(item, "Failed to write " + target.string());
+                    return;
+                }
+                bytesOut += item.payload.size();
+                item.payload = std::string();
+                if (job.storeIndex) {
+                    pendingIndex.push_back({item.path, item.size, item.mtime, std::move(item.hash), true});
+                }
+            },
+        };
+        
+        std::size_t files = 0;
+        std::size_t failed = 0;
+        auto storeIndex = [&]() {
+            if (!pendingIndex.empty() && !writeIndexUpdates(pendingIndex, {})) {
+                failed += pendingIndex.size();
+                std::lock_guard<std::mutex> lock(batchMutex_);
+                if (report.firstError.empty()) {
+                    report.firstError = "Failed to update file index";
+                }
+            }
+            pendingIndex.clear();
+        };
+        auto collect = [&](BatchItem& item) {
+            ++files;
+            if (!item.error.empty()) {
+                ++failed;
+                std::lock_guard<std::mutex> lock(batchMutex_);
+                if (report.firstError.empty()) {
+                    report.firstError = item.error;
+                }
+            }
+            // Index rows are committed in groups, one transaction each
+            if (pendingIndex.size() >= 256) {
+                timed(counters[kStages - 1], storeIndex);
+            }
+        };
+        
+        const bool fanOut = !pool_.onWorkerThread();
+        const std::size_t window = 2 * pool_.threadCount();
+        auto runStage = [&](std::size_t index, bool parallel) {
+            BatchStageCounters& stage = counters[index];
+            Queue& input = *queues[index - 1];
+            Queue* output = index + 1 < kStages ? queues[index].get() : nullptr;
+            auto process = [&stage, &timed, &work, index](const Item& item) {
+                if (item->error.empty()) {
+                    timed(stage, [&]() { work[index](*item); });
+                }
+                return item;
+            };
+            auto forward = [&](Item item) {
+                stage.items++;
+                stage.bytes += static_cast<std::uint64_t>(item->size);
+                if (output) {
+                    stage.outputWaitNanos += output->push(std::move(item));
+                } else {
+                    collect(*item);
+                }
+            };
+            
+            std::deque<std::future<Item>> inFlight;
+            Item item;
+            std::uint64_t waited = 0;
+            while (input.pop(item, waited)) {
+                stage.inputWaitNanos += waited;
+                if (!parallel || !fanOut) {
+                    forward(process(item));
+                    continue;
+                }
+                inFlight.push_back(pool_.submit([process, item]() { return process(item); }));
+                while (inFlight.size() >= window || (!inFlight.empty() &&
+                       inFlight.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+                    forward(inFlight.front().get());
+                    inFlight.pop_front();
+                }
+            }
+            while (!inFlight.empty()) {
+                forward(inFlight.front().get());
+                inFlight.pop_front();
+            }
+            if (output) {
+                output->close();
+            }
+        };
+        
+        std::vector<std::thread> stages;
+        stages.emplace_back([&]() {
+            scan();
+            queues[0]->close();
+        });
+        for (std::size_t i = 1; i < kStages; ++i) {
+            const bool parallel = i == 2 || i == 3 || (i == 4 && job.session);
+            stages.emplace_back([&runStage, i, parallel]() { runStage(i, parallel); });
+        }
+        for (auto& thread : stages) {
+            thread.join();
+        }
+        timed(counters[kStages - 1], storeIndex);
+        
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        report.files = files;
+        report.failed = failed;
+        report.bytesIn = counters[0].bytes;
+        report.bytesOut = bytesOut;
+        for (std::size_t i = 0; i < kStages; ++i) {
+            BatchStageStats stats;
+            stats.name = names[i];
+            stats.items = counters[i].items;
+            stats.bytes = counters[i].bytes;
+            stats.busySeconds = static_cast<double>(counters[i].busyNanos) / 1e9;
+            stats.inputWaitSeconds = static_cast<double>(counters[i].inputWaitNanos) / 1e9;
+            stats.outputWaitSeconds = static_cast<double>(counters[i].outputWaitNanos) / 1e9;
+            if (i > 0) {
+                stats.maxQueueDepth = queues[i - 1]->maxDepth();
+                stats.meanQueueDepth = queues[i - 1]->meanDepth();
+            }
+            report.stages.push_back(std::move(stats));
+        }
+        report.ok = failed == 0 && report.firstError.empty();
+        
+        {
+            std::lock_guard<std::mutex> lock(batchMutex_);
+            lastBatch_ = report;
+        }
+        if (report.ok) {
+            logger_->info("Batch {}: {} files, {} -> {} bytes in {:.3f}s", job.inputDirectory, report.files,
+                          report.bytesIn, report.bytesOut, report.seconds);
+        } else {
+            logger_->error("Batch {}: {} of {} files failed: {}", job.inputDirectory, report.failed, report.files,
+                           report.firstError);
+        }
+        return report;
+    }
+    
+    // Input is deflated straight from a mapping when the file can be
+    // mapped, otherwise read through a 16 KiB buffer
+    bool compressFile(const std::string& inputPath, const std::string& outputPath) {
+        ScopedOp op(stats_, StatOp::Compress);
+        MappedBuffer mapped(inputPath);
+        std::ifstream input;
+        if (!mapped.ok() || mapped.size() == 0) {
+            input.open(inputPath, std::ios::binary);
+        }
+        std::ofstream output(outputPath, std::ios::binary);
+        
+        if ((!mapped.ok() && !input) || !output) {
+            op.fail();
+            output.close();
+            boost::system::error_code ec;
+            fs::remove(outputPath, ec);
+            logger_->error("Failed to open files for compression");
+            return false;
+        }
+        
+        // Use zlib for compression
+        const int CHUNK = 16384;
+        unsigned char in[CHUNK];
+        unsigned char out[CHUNK];
+        
+        z_stream* stream = ThreadZStreams::current().deflater(Z_DEFAULT_COMPRESSION);
+        if (!stream) {
+            op.fail();
+            logger_->error("Failed to initialize zlib compression");
+            return false;
+        }
+        z_stream& strm = *stream;
+        
+        std::string_view remaining = mapped.view();
+        bool last = false;
+        bool ok = true;
+        do {
+            if (input.is_open()) {
+                input.read(reinterpret_cast<char*>(in), CHUNK);
+                strm.avail_in = static_cast<uInt>(input.gcount());
+                strm.next_in = in;
+                last = input.eof();
+                ok = !input.bad();
+            } else {
+                const std::size_t take = std::min<std::size_t>(remaining.size(), 1 << 20);
+                strm.avail_in = static_cast<uInt>(take);
+                strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(remaining.data()));
+                remaining.remove_prefix(take);
+                last = remaining.empty();
+            }
+            
+            while (ok) {
+                strm.avail_out = CHUNK;
+                strm.next_out = out;
+                ok = deflate(&strm, last ? Z_FINISH : Z_NO_FLUSH) != Z_STREAM_ERROR;
+                
+                int have = CHUNK - strm.avail_out;
+                output.write(reinterpret_cast<char*>(out), have);
+                ok = ok && output.good();
+                if (strm.avail_out != 0) {
+                    break;
+                }
+            }
+        } while (ok && !last);
+        
+        output.close();
+        if (!ok || output.fail()) {
+            op.fail();
+            boost::system::error_code ec;
+            fs::remove(outputPath, ec);
+            logger_->error("Failed to compress file: {}", inputPath);
+            return false;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully compressed file: {} -> {}", inputPath, outputPath);
+        return true;
+    }
+    
+    // pigz-style gzip: the input is cut into blocks that are deflated
+    // independently (primed with the previous block's tail as dictionary),
+    // byte-aligned with Z_SYNC_FLUSH and concatenated into one member.
+    // Regular files are deflated straight from a mapping; anything that
+    // can't be mapped is read block by block.
+    bool compressFile(const std::string& inputPath, const std::string& outputPath, const CompressionOptions& options) {
+        // Empty mappings take the read path too: procfs-style files report
+        // size 0 yet have content
+        MappedBuffer mapped(inputPath);
+        if (mapped.ok() && mapped.size() > 0) {
+            return compressFile(mapped.view(), inputPath, outputPath, options);
+        }
+        
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            ScopedOp op(stats_, StatOp::Compress);
+            op.fail();
+            logger_->error("Failed to open files for compression");
+            return false;
+        }
+        const std::size_t blockSize = std::max<std::size_t>(options.blockSize, kDeflateWindow);
+        return gzipBlocks([&](GzipBlock& block) {
+            auto buffer = std::make_shared<std::string>(blockSize, '\0');
+            input.read(&(*buffer)[0], static_cast<std::streamsize>(blockSize));
+            buffer->resize(static_cast<std::size_t>(input.gcount()));
+            block.last = input.eof() || input.peek() == std::char_traits<char>::eof();
+            block.data = *buffer;
+            block.owner = std::move(buffer);
+            if (input.bad()) {
+                logger_->error("Failed to read input for compression: {}", inputPath);
+                return false;
+            }
+            return true;
+        }, inputPath, outputPath, options);
+    }
+    
+    bool compressFile(std::string_view input, const std::string& source, const std::string& outputPath,
+                      const CompressionOptions& options) {
+        const std::size_t blockSize = std::max<std::size_t>(options.blockSize, kDeflateWindow);
+        std::size_t offset = 0;
+        return gzipBlocks([&](GzipBlock& block) {
+            block.data = input.substr(offset, blockSize);
+            offset += block.data.size();
+            block.last = offset >= input.size();
+            return true;
+        }, source, outputPath, options);
+    }
+    
+    // One gzip input block; owner keeps data alive when it isn't a view
+    // into a mapping that outlives the call
+    struct GzipBlock {
+        std::string_view data;
+        std::shared_ptr<const std::string> owner;
+        bool last = false;
+    };
+    
+    bool gzipBlocks(const std::function<bool(GzipBlock&)>& nextBlock, const std::string& source,
+                    const std::string& outputPath, const CompressionOptions& options) {
+        ScopedOp op(stats_, StatOp::Compress);
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            op.fail();
+            logger_->error("Failed to open files for compression");
+            return false;
+        }
+        
+        const int level = options.level;
+        // Waiting on block futures from a pool thread could starve the pool
+        const bool parallel = options.parallel && !pool_.onWorkerThread();
+        const std::size_t window = parallel ? 2 * pool_.threadCount() : 1;
+        
+        static const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+        output.write(reinterpret_cast<const char*>(header), sizeof(header));
+        
+        std::deque<std::future<DeflatedBlock>> inFlight;
+        GzipBlock previous;
+        uLong crc = crc32(0L, Z_NULL, 0);
+        std::uint64_t totalIn = 0;
+        bool ok = true;
+        
+        // Once a block or write fails the rest are still awaited, since they
+        // read the caller's input, but nothing more is written
+        auto writeOldest = [&]() {
+            DeflatedBlock block = inFlight.front().get();
+            inFlight.pop_front();
+            ok = ok && block.ok;
+            if (!ok) {
+                return;
+            }
+            crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(block.inputSize));
+            totalIn += block.inputSize;
+            output.write(reinterpret_cast<const char*>(block.data.data()), block.data.size());
+            ok = output.good();
+        };
+        
+        GzipBlock current;
+        while (!current.last && ok) {
+            if (!nextBlock(current)) {
+                ok = false;
+                break;
+            }
+            auto task = [current, previous, level]() {
+                return deflateBlock(current.data, previous.data, level, current.last);
+            };
+            if (parallel) {
+                inFlight.push_back(pool_.submit(std::move(task)));
+            } else {
+                std::promise<DeflatedBlock> done;
+                done.set_value(task());
+                inFlight.push_back(done.get_future());
+            }
+            previous = current;
+            
+            if (inFlight.size() >= window) {
+                writeOldest();
+            }
+        }
+        while (!inFlight.empty()) {
+            writeOldest();
+        }
+        
+        if (ok) {
+            unsigned char trailer[8];
+            for (int i = 0; i < 4; ++i) {
+                trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+                trailer[4 + i] = static_cast<unsigned char>(totalIn >> (8 * i));
+            }
+            output.write(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+        }
+        output.close();
+        
+        // A partial member would look like a valid gzip file cut short
+        if (!ok || output.fail()) {
+            op.fail();
+            boost::system::error_code ec;
+            fs::remove(outputPath, ec);
+            logger_->error("Failed to compress file: {}", source);
+            return false;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully compressed file: {} -> {} ({} bytes in)", source, outputPath, totalIn);
+        return true;
+    }
+    
+    // In-memory compression (zlib format)
+    bool compress(std::string_view input, char* output, std::size_t capacity, std::size_t& written, int level) {
+        ScopedOp op(stats_, StatOp::Compress);
+        written = 0;
+        if (input.size() > std::numeric_limits<uInt>::max()) {
+            op.fail();
+            logger_->error("Buffer size not supported for in-memory compression");
+            return false;
+        }
+        z_stream* strm = ThreadZStreams::current().deflater(level);
+        if (!strm) {
+            op.fail();
+            logger_->error("Failed to initialize zlib compression");
+            return false;
+        }
+        
+        strm->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        strm->avail_in = static_cast<uInt>(input.size());
+        strm->next_out = reinterpret_cast<Bytef*>(output);
+        strm->avail_out = static_cast<uInt>(std::min<std::size_t>(capacity, std::numeric_limits<uInt>::max()));
+        if (deflate(strm, Z_FINISH) != Z_STREAM_END) {
+            op.fail();
+            logger_->error("Output buffer too small for compressed data");
+            return false;
+        }
+        written = strm->total_out;
+        return true;
+    }
+    
+    bool compress(std::string_view input, std::string& output, int level) {
+        output.resize(::compressBound(static_cast<uLong>(input.size())));
+        std::size_t written = 0;
+        bool ok = compress(input, &output[0], output.size(), written, level);
+        output.resize(written);
+        return ok;
+    }
+    
+    bool decompress(std::string_view input, char* output, std::size_t capacity, std::size_t& written) {
+        ScopedOp op(stats_, StatOp::Compress);
+        written = 0;
+        if (input.size() > std::numeric_limits<uInt>::max()) {
+            op.fail();
+            logger_->error("Buffer size not supported for in-memory decompression");
+            return false;
+        }
+        z_stream* strm = ThreadZStreams::current().inflater();
+        if (!strm) {
+            op.fail();
+            logger_->error("Failed to initialize zlib decompression");
+            return false;
+        }
+        
+        strm->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        strm->avail_in = static_cast<uInt>(input.size());
+        strm->next_out = reinterpret_cast<Bytef*>(output);
+        strm->avail_out = static_cast<uInt>(std::min<std::size_t>(capacity, std::numeric_limits<uInt>::max()));
+        int ret = inflate(strm, Z_FINISH);
+        written = strm->total_out;
+        if (ret != Z_STREAM_END) {
+            op.fail();
+            logger_->error(ret == Z_BUF_ERROR && strm->avail_out == 0
+                               ? "Output buffer too small for decompressed data"
+                               : "Corrupt compressed data");
+            return false;
+        }
+        return true;
+    }
+    
+    bool decompress(std::string_view input, std::string& output) {
+        ScopedOp op(stats_, StatOp::Compress);
+        if (input.size() > std::numeric_limits<uInt>::max()) {
+            op.fail();
+            logger_->error("Buffer size not supported for in-memory decompression");
+            return false;
+        }
+        z_stream* strm = ThreadZStreams::current().inflater();
+        if (!strm) {
+            op.fail();
+            logger_->error("Failed to initialize zlib decompression");
+            return false;
+        }
+        
+        // Reuse whatever capacity the caller's string already has
+        output.resize(std::max({output.capacity(), input.size() * 4, std::size_t(1024)}));
+        strm->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        strm->avail_in = static_cast<uInt>(input.size());
+        int ret;
+        do {
+            if (strm->total_out == output.size()) {
+                output.resize(output.size() * 2);
+            }
+            strm->next_out = reinterpret_cast<Bytef*>(&output[strm->total_out]);
+            strm->avail_out = static_cast<uInt>(std::min<std::size_t>(output.size() - strm->total_out,
+                                                                      std::numeric_limits<uInt>::max()));
+            ret = inflate(strm, Z_NO_FLUSH);
+        } while (ret == Z_OK);
+        
+        output.resize(strm->total_out);
+        if (ret != Z_STREAM_END) {
+            op.fail();
+            logger_->error("Corrupt compressed data");
+            return false;
+        }
+        return true;
+    }
+    
+    bool decompressFile(const std::string& inputPath, const ChunkSink& sink) {
+        ScopedOp op(stats_, StatOp::Compress);
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            op.fail();
+            logger_->error("Failed to open file for decompression: {}", inputPath);
+            return false;
+        }
+        
+        ReadAhead reader(input, pool_.onWorkerThread() ? nullptr : &pool_, kDecompressReadSize);
+        std::string_view chunk = reader.next();
+        CompressionFormat format = detectCompressionFormat(chunk);
+        
+        bool ok;
+        switch (format) {
+            case CompressionFormat::Gzip:
+            case CompressionFormat::Zlib:
+                ok = inflateStream(reader, chunk, sink);
+                break;
+            case CompressionFormat::Bzip2:
+                ok = bunzipStream(reader, chunk, sink);
+                break;
+            default:
+                op.fail();
+                logger_->error("Unrecognized compression format: {}", inputPath);
+                return false;
+        }
+        
+        if (!ok || reader.failed()) {
+            op.fail();
+            logger_->error("Failed to decompress file: {}", inputPath);
+            return false;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully decompressed file: {}", inputPath);
+        return true;
+    }
+    
+    bool decompressFile(const std::string& inputPath, const std::string& outputPath) {
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            logger_->error("Failed to open file for writing: {}", outputPath);
+            return false;
+        }
+        
+        return decompressFile(inputPath, [&output](std::string_view chunk) {
+            output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            return static_cast<bool>(output);
+        });
+    }
+    
+    // Compress-then-encrypt pipeline: file reads, block deflate+seal and
+    // ordered writes overlap, with memory bounded by the in-flight window
+    bool compressEncryptFile(const std::string& inputPath, const std::string& outputPath,
+                             const CipherSession& session, const CompressionOptions& options) {
+        if (!session.ok()) {
+            logger_->error("Invalid cipher session for archive: {}", outputPath);
+            return false;
+        }
+        std::ifstream input(inputPath, std::ios::binary);
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!input || !output) {
+            logger_->error("Failed to open files for sealed compression");
+            return false;
+        }
+        
+        WorkerPool* pool = sealingPool(options);
+        SealedWriter writer(output, session, pool, options);
+        ReadAhead reader(input, pool, std::max<std::size_t>(options.blockSize, kDeflateWindow));
+        bool ok = true;
+        for (std::string_view chunk = reader.next(); ok && !chunk.empty(); chunk = reader.next()) {
+            ok = writer.write(chunk);
+        }
+        ok = writer.finish() && ok && !reader.failed();
+        
+        if (!ok) {
+            logger_->error("Failed to write sealed archive: {}", outputPath);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully sealed file: {} -> {} ({} bytes in)", inputPath, outputPath, writer.bytesIn());
+        return true;
+    }
+    
+    bool decryptDecompressFile(const std::string& inputPath, const CipherSession& session, const ChunkSink& sink) {
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            logger_->error("Failed to open sealed archive: {}", inputPath);
+            return false;
+        }
+        
+        if (!readSealedArchive(input, session, pool_.onWorkerThread() ? nullptr : &pool_, sink) || input.bad()) {
+            logger_->error("Failed to open sealed archive (corrupt, truncated or wrong key): {}", inputPath);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully unsealed file: {}", inputPath);
+        return true;
+    }
+    
+    bool decryptDecompressFile(const std::string& inputPath, const std::string& outputPath, const CipherSession& session) {
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            logger_->error("Failed to open file for writing: {}", outputPath);
+            return false;
+        }
+        
+        return decryptDecompressFile(inputPath, session, [&output](std::string_view chunk) {
+            output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            return static_cast<bool>(output);
+        });
+    }
+    
+    // Database Operations
+    bool initializeDatabase(const std::string& dbPath, const DatabaseOptions& options) {
+        closeDatabase();
+        
+        if (sqlite3_open(dbPath.c_str(), &db_) != SQLITE_OK) {
+            logger_->error("Failed to open database: {}", dbPath);
+            return false;
+        }
+        
+        if (options.walMode && !execSql("PRAGMA journal_mode=WAL;")) {
+            return false;
+        }
+        if (options.synchronousNormal && !execSql("PRAGMA synchronous=NORMAL;")) {
+            return false;
+        }
+        
+        const char* sql = "CREATE TABLE IF NOT EXISTS data_processor_logs ("
+                         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                         "timestamp TEXT NOT NULL,"
+                         "operation TEXT NOT NULL,"
+                         "details TEXT"
+                         ");";
+        
+        if (!execSql(sql)) {
+            return false;
+        }
+        
+        if (options.fileIndex) {
+            const char* indexSql = "CREATE TABLE IF NOT EXISTS file_index ("
+                                   "path TEXT PRIMARY KEY,"
+                                   "size INTEGER NOT NULL,"
+                                   "mtime INTEGER NOT NULL,"
+                                   "hash TEXT NOT NULL,"
+                                   "indexed_at TEXT NOT NULL"
+                                   ") WITHOUT ROWID;";
+            if (!execSql(indexSql)) {
+                return false;
+            }
+        }
+        
+        if (options.readConnections > 0) {
+            if (!options.walMode || dbPath.empty() || dbPath == ":memory:") {
+                logger_->warn("Read connections need a WAL file database; queries stay on the writer: {}", dbPath);
+            } else if (!openReaders(dbPath, options.readConnections)) {
+                return false;
+            }
+        }
+        
+        if (options.backgroundWriter) {
+            writerBatchSize_ = std::max<std::size_t>(1, options.writerBatchSize);
+            writerQueueLimit_ = std::max<std::size_t>(1, options.writerQueueLimit);
+            writerFailures_ = 0;
+            writerStopping_ = false;
+            dbWriter_ = std::thread([this]() { writerLoop(); });
+        }
+        
+        logger_->info("Database initialized successfully: {}", dbPath);
+        return true;
+    }
+    
+    bool storeData(const std::string& table, const std::string& data) {
+        ScopedOp op(stats_, StatOp::Database);
+        if (!db_) {
+            op.fail();
+            logger_->error("Database not initialized");
+            return false;
+        }
+        
+        if (dbWriter_.joinable()) {
+            // Counted when the writer commits it; flushWrites reports a loss
+            op.items(0);
+            {
+                std::unique_lock<std::mutex> lock(writeMutex_);
+                writeSpace_.wait(lock, [this]() { return writeQueue_.size() < writerQueueLimit_; });
+                writeQueue_.emplace_back(table, data);
+            }
+            writeCv_.notify_one();
+            return true;
+        }
+        
+        std::lock_guard<std::mutex> lock(dbMutex_);
+        sqlite3_stmt* stmt = insertStatement(table);
+        if (!stmt) {
+            op.fail();
+            return false;
+        }
+        
+        bool success = insertRow(stmt, currentTimestamp(), data);
+        
+        if (success) {
+            SPDLOG_LOGGER_TRACE(logger_, "Data stored successfully in table: {}", table);
+        } else {
+            op.fail();
+            logger_->error("Failed to store data in table: {}", table);
+        }
+        
+        return success;
+    }
+    
+    bool storeBatch(const std::string& table, const std::vector<std::string>& rows) {
+        ScopedOp op(stats_, StatOp::Database);
+        op.items(rows.size());
+        if (!db_) {
+            op.fail();
+            logger_->error("Database not initialized");
+            return false;
+        }
+        if (rows.empty()) {
+            return true;
+        }
+        
+        std::lock_guard<std::mutex> lock(dbMutex_);
+        sqlite3_stmt* stmt = insertStatement(table);
+        if (!stmt || !execSql("BEGIN IMMEDIATE;")) {
+            op.fail();
+            return false;
+        }
+        
+        std::string timestamp = currentTimestamp();
+        for (const auto& row : rows) {
+            if (!insertRow(stmt, timestamp, row)) {
+                op.fail();
+                logger_->error("Failed to store batch in table: {}", table);
+                execSql("ROLLBACK;");
+                return false;
+            }
+        }
+        
+        if (!execSql("COMMIT;")) {
+            op.fail();
+            execSql("ROLLBACK;");
+            return false;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "Stored {} rows in table: {}", rows.size(), table);
+        return true;
+    }
+    
+    // Read-only statements go to a pooled read connection when there are
+    // any, so they run alongside the writer; everything else, and all
+    // queries without readers, use the writer connection and page its lock.
+    bool queryData(const std::string& query, const std::vector<std::string>& params,
+                   const RowVisitor& visitor, const QueryOptions& options) {
+        ScopedOp op(stats_, StatOp::Database);
+        if (!db_) {
+            op.fail();
+            logger_->error("Database not initialized");
+            return false;
+        }
+        
+        if (!readers_.empty()) {
+            ReaderLease reader(*this);
+            sqlite3_stmt* stmt = reader->statement(query);
+            if (!stmt) {
+                op.fail();
+                logger_->error("Failed to prepare query: {}", sqlite3_errmsg(reader->handle()));
+                return false;
+            }
+            if (sqlite3_stmt_readonly(stmt)) {
+                std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)> reset(stmt, resetStatement);
+                if (!runQuery(stmt, reader->handle(), params, visitor, nullptr, 0)) {
+                    op.fail();
+                    return false;
+                }
+                return true;
+            }
+        }
+        
+        std::unique_lock<std::mutex> lock(dbMutex_);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, query.c_str(), static_cast<int>(query.size()), &stmt, nullptr) != SQLITE_OK) {
+            op.fail();
+            logger_->error("Failed to prepare query: {}", sqlite3_errmsg(db_));
+            return false;
+        }
+        // Destroyed before lock, so the statement is finalized under dbMutex_
+        std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)> guard(stmt, sqlite3_finalize);
+        
+        if (!runQuery(stmt, db_, params, visitor, &lock, std::max<std::size_t>(1, options.pageSize))) {
+            op.fail();
+            return false;
+        }
+        return true;
+    }
+    
+    bool flushWrites() {
+        std::unique_lock<std::mutex> lock(writeMutex_);
+        writeDrained_.wait(lock, [this]() { return writeQueue_.empty() && !writerBusy_; });
+        return std::exchange(writerFailures_, 0) == 0;
+    }
+    
+    // Network Operations
+    bool downloadFile(const std::string& url, const std::string& localPath) {
+        return downloadFiles({{url, localPath}}).front().ok;
+    }
+    
+    // Streams the response body into a sealed archive without staging it on
+    // disk. The sink runs on the client's loop thread, so it only queues
+    // chunks; this thread drains them into the SealedWriter. A full queue
+    // pauses this transfer, never the loop, until this thread catches up.
+    bool downloadFile(const std::string& url, const std::string& localPath,
+                      const CipherSession& session, const CompressionOptions& options) {
+        HttpClient* client = httpClient();
+        if (!client) {
+            logger_->error("CURL not initialized");
+            return false;
+        }
+        if (!session.ok()) {
+            logger_->error("Invalid cipher session for archive: {}", localPath);
+            return false;
+        }
+        std::ofstream output(localPath, std::ios::binary);
+        if (!output) {
+            logger_->error("Failed to open file for writing: {}", localPath);
+            return false;
+        }
+        
+        using SinkStatus = HttpClient::SinkStatus;
+        StageQueue<std::string> chunks(kSealedDownloadQueue);
+        std::atomic<bool> rejected{false};
+        // Raised before every push attempt, so a pop that follows a refused
+        // push always sees it; a spurious resume is harmless
+        std::atomic<bool> paused{false};
+        std::uint64_t transferId = 0;
+        const bool pausable = HttpClient::canPause(url);
+        std::future<HttpResponse> pending = client->fetch({url}, [&](std::string_view chunk) {
+            if (rejected.load(std::memory_order_relaxed)) {
+                return SinkStatus::Abort;
+            }
+            std::string copy(chunk);
+            if (!pausable) {
+                // Such a transfer already holds the loop until it is read
+                chunks.push(std::move(copy));
+                return SinkStatus::Accept;
+            }
+            paused.store(true);
+            if (!chunks.tryPush(copy)) {
+                return SinkStatus::Pause;
+            }
+            paused.store(false);
+            return SinkStatus::Accept;
+        }, [&chunks]() { chunks.close(); }, transferId);
+        
+        SealedWriter writer(output, session, sealingPool(options), options);
+        bool sealed = true;
+        std::string chunk;
+        std::uint64_t waited = 0;
+        // Keeps draining after a failed write, so a paused sink gets to abort
+        while (chunks.pop(chunk, waited)) {
+            if (paused.exchange(false)) {
+                client->resume(transferId);
+            }
+            if (sealed && !writer.write(chunk)) {
+                sealed = false;
+                rejected.store(true, std::memory_order_relaxed);
+            }
+        }
+        HttpResponse response = pending.get();
+        const bool finished = writer.finish();
+        sealed = sealed && finished;
+        
+        if (!response.ok) {
+            logger_->error("CURL error: {}", response.error);
+            return false;
+        }
+        if (!sealed) {
+            logger_->error("Failed to write sealed archive: {}", localPath);
+            return false;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully downloaded and sealed: {} -> {}", url, localPath);
+        return true;
+    }
+    
+    // Hands the body to the sink as it arrives, straight from curl's buffer
+    bool downloadFile(const std::string& url, const ChunkSink& sink) {
+        HttpClient* client = httpClient();
+        if (!client) {
+            logger_->error("CURL not initialized");
+            return false;
+        }
+        
+        HttpResponse response = client->fetch({url}, sink).get();
+        if (!response.ok) {
+            logger_->error("Download failed: {}: {}", url, response.error);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully streamed download: {}", url);
+        return true;
+    }
+    
+    bool downloadFile(const std::string& url, const std::string& localPath, const DownloadOptions& options) {
+        HttpClient* client = httpClient();
+        if (!client) {
+            logger_->error("CURL not initialized");
+            return false;
+        }
+        
+        if (options.segments > 1) {
+            HttpRequest probe{url};
+            probe.headOnly = true;
+            HttpResponse head = client->fetch(probe).get();
+            const std::size_t segmentSize = std::max<std::size_t>(options.minSegmentSize, 1);
+            const std::int64_t count = head.ok && head.contentLength > 0
+                ? std::min<std::int64_t>(static_cast<std::int64_t>(options.segments),
+                                         head.contentLength / static_cast<std::int64_t>(segmentSize))
+                : 0;
+            if (count > 1) {
+                if (downloadSegments(*client, url, localPath, head.contentLength, static_cast<std::size_t>(count))) {
+                    SPDLOG_LOGGER_TRACE(logger_, "Successfully downloaded file in {} segments: {} -> {}", count, url, localPath);
+                    return true;
+                }
+                logger_->warn("Ranged download failed, retrying as one transfer: {}", url);
+            }
+        }
+        
+        boost::system::error_code ec;
+        const std::uintmax_t existing = options.resume && fs::exists(localPath, ec) ? fs::file_size(localPath, ec) : 0;
+        if (existing > 0 && !ec) {
+            HttpRequest request{url};
+            request.resumeFrom = static_cast<curl_off_t>(existing);
+            HttpResponse response = fetchToFile(*client, request, localPath, std::ios::app);
+            if (response.ok) {
+                SPDLOG_LOGGER_TRACE(logger_, "Successfully resumed download at byte {}: {} -> {}", existing, url, localPath);
+                return true;
+            }
+            if (response.status == 416) {
+                // Nothing left to fetch if the local copy already has the full length
+                HttpRequest probe{url};
+                probe.headOnly = true;
+                HttpResponse head = client->fetch(probe).get();
+                if (head.ok && head.contentLength == static_cast<std::int64_t>(existing)) {
+                    SPDLOG_LOGGER_TRACE(logger_, "Download already complete: {}", localPath);
+                    return true;
+                }
+            } else if (response.status != 200) {
+                // Transport failure: keep the partial file for the next attempt
+                logger_->error("Download failed: {}: {}", url, response.error);
+                return false;
+            }
+            // The server ignored the range or the local copy is stale; start over
+            logger_->warn("Cannot resume {}, downloading from the start", url);
+        }
+        
+        HttpResponse response = fetchToFile(*client, {url}, localPath, std::ios::trunc);
+        if (!response.ok) {
+            logger_->error("Download failed: {}: {}", url, response.error);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully downloaded file: {} -> {}", url, localPath);
+        return true;
+    }
+    
+    std::vector<HttpResponse> downloadFiles(const std::vector<std::pair<std::string, std::string>>& transfers) {
+        std::vector<HttpResponse> results(transfers.size());
+        HttpClient* client = httpClient();
+        if (!client) {
+            logger_->error("CURL not initialized");
+            for (auto& result : results) {
+                result.error = "CURL not initialized";
+            }
+            return results;
+        }
+        
+        // Every transfer is queued up front; the client caps how many run at once
+        std::vector<std::unique_ptr<std::ofstream>> outputs(transfers.size());
+        std::vector<std::future<HttpResponse>> pending(transfers.size());
+        for (std::size_t i = 0; i < transfers.size(); ++i) {
+            outputs[i] = std::make_unique<std::ofstream>(transfers[i].second, std::ios::binary);
+            if (!*outputs[i]) {
+                results[i].error = "Failed to open file for writing: " + transfers[i].second;
+                continue;
+            }
+            std::ofstream* output = outputs[i].get();
+            pending[i] = client->fetch({transfers[i].first}, [output](std::string_view chunk) {
+                output->write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                return static_cast<bool>(*output);
+            });
+        }
+        
+        std::size_t failed = 0;
+        for (std::size_t i = 0; i < transfers.size(); ++i) {
+            if (pending[i].valid()) {
+                results[i] = pending[i].get();
+                outputs[i]->close();
+                if (results[i].ok && !*outputs[i]) {
+                    results[i].ok = false;
+                    results[i].error = "Failed to write file: " + transfers[i].second;
+                }
+            }
+            if (results[i].ok) {
+                SPDLOG_LOGGER_TRACE(logger_, "Successfully downloaded file: {} -> {}", transfers[i].first, transfers[i].second);
+            } else {
+                logger_->error("Download failed: {}: {}", transfers[i].first, results[i].error);
+                ++failed;
+            }
+        }
+        if (transfers.size() > 1) {
+            logger_->info("Downloaded {} of {} files", transfers.size() - failed, transfers.size());
+        }
+        return results;
+    }
+    
+    std::future<HttpResponse> fetchAsync(const std::string& url) {
+        HttpClient* client = httpClient();
+        if (!client) {
+            std::promise<HttpResponse> failed;
+            HttpResponse response;
+            response.error = "CURL not initialized";
+            failed.set_value(std::move(response));
+            return failed.get_future();
+        }
+        return client->fetch({url});
+    }
+    
+    std::string makeHttpRequest(const std::string& url) {
+        HttpResponse response = fetchAsync(url).get();
+        if (!response.ok) {
+            logger_->error("HTTP request failed: {}: {}", url, response.error);
+            return "";
+        }
+        return std::move(response.body);
+    }
+    
+    // Charset Conversion
+    bool convertEncoding(std::string_view input, const std::string& fromEncoding, const std::string& toEncoding,
+                         std::string& output) {
+        output.clear();
+        EncodingConverter converter(fromEncoding, toEncoding);
+        if (!converter.feed(input, output) || !converter.finish(output)) {
+            logger_->error("Failed to convert {} to {}: {}", fromEncoding, toEncoding, converter.error());
+            return false;
+        }
+        return true;
+    }
+    
+    bool convertEncodingFile(const std::string& inputPath, const std::string& fromEncoding,
+                             const std::string& toEncoding, const ChunkSink& sink) {
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            logger_->error("Failed to open file for conversion: {}", inputPath);
+            return false;
+        }
+        EncodingConverter converter(fromEncoding, toEncoding);
+        ReadAhead chunks(input, pool_.onWorkerThread() ? nullptr : &pool_, kJsonReadSize);
+        std::string converted;
+        bool ok = converter.ok();
+        for (std::string_view chunk = chunks.next(); ok && !chunk.empty(); chunk = chunks.next()) {
+            if (converter.passesThrough(chunk)) {
+                ok = sink(chunk);
+                continue;
+            }
+            converted.clear();
+            ok = converter.feed(chunk, converted) && (converted.empty() || sink(converted));
+        }
+        if (ok) {
+            converted.clear();
+            ok = converter.finish(converted) && (converted.empty() || sink(converted));
+        }
+        if (!ok || chunks.failed()) {
+            logger_->error("Failed to convert {} from {} to {}{}", inputPath, fromEncoding, toEncoding,
+                           converter.error().empty() ? std::string() : ": " + converter.error());
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Converted {} from {} to {}", inputPath, fromEncoding, toEncoding);
+        return true;
+    }
+    
+    bool convertEncodingFile(const std::string& inputPath, const std::string& outputPath,
+                             const std::string& fromEncoding, const std::string& toEncoding) {
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            logger_->error("Failed to open file for writing: {}", outputPath);
+            return false;
+        }
+        
+        return convertEncodingFile(inputPath, fromEncoding, toEncoding, [&output](std::string_view chunk) {
+            output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            return static_cast<bool>(output);
+        });
+    }
+    
+    // Text Processing with RE2
+    // Matches against the UTF-8 form of text; ASCII input is matched in place
+    bool processTextWithRegex(std::string_view text, const std::string& pattern, const std::string& encoding) {
+        EncodingConverter converter(encoding, "UTF-8");
+        if (converter.passesThrough(text)) {
+            return processTextWithRegex(text, pattern);
+        }
+        std::string converted;
+        if (!converter.feed(text, converted) || !converter.finish(converted)) {
+            logger_->error("Failed to convert {} text for regex: {}", encoding, converter.error());
+            return false;
+        }
+        return processTextWithRegex(converted, pattern);
+    }
+    
+    bool processTextWithRegex(std::string_view text, const std::string& pattern) {
+        ScopedOp op(stats_, StatOp::Regex);
+        auto re = regexCache_.get(pattern, RE2::DefaultOptions);
+        if (!re->ok()) {
+            op.fail();
+            logger_->error("Invalid regex pattern: {}", pattern);
+            return false;
+        }
+        
+        // Group 0 is the whole match, so patterns without capture groups work too
+        re2::StringPiece match;
+        if (re->Match(re2::StringPiece(text.data(), text.size()), 0, text.size(), RE2::UNANCHORED, &match, 1)) {
+            SPDLOG_LOGGER_TRACE(logger_, "Found match: {}", std::string(match.data(), match.size()));
+            return true;
+        }
+        
+        SPDLOG_LOGGER_TRACE(logger_, "No match found for pattern: {}", pattern);
+        return false;
+    }
+    
+    std::vector<int> scanWithPatternSet(std::string_view text, const std::vector<std::string>& patterns) {
+        ScopedOp op(stats_, StatOp::Regex);
+        std::vector<int> matched;
+        if (patterns.empty()) {
+            return matched;
+        }
+        
+        auto compiled = regexCache_.getSet(patterns);
+        if (!compiled->ok()) {
+            const std::size_t bad = static_cast<std::size_t>(compiled->invalidIndex);
+            op.fail();
+            logger_->error("Invalid regex pattern set: {}", bad < patterns.size() ? patterns[bad] : "compilation failed");
+            return matched;
+        }
+        
+        compiled->set.Match(re2::StringPiece(text.data(), text.size()), &matched);
+        std::sort(matched.begin(), matched.end());
+        return matched;
+    }
+    
+    std::vector<MatchSpan> extractMatches(std::string_view text, const std::vector<std::string>& patterns) {
+        std::vector<MatchSpan> spans;
+        
+        // One pass over the text picks the patterns worth locating
+        for (int index : scanWithPatternSet(text, patterns)) {
+            auto re = regexCache_.get(patterns[index], RE2::DefaultOptions);
+            std::size_t pos = 0;
+            re2::StringPiece match;
+            const re2::StringPiece piece(text.data(), text.size());
+            while (pos <= text.size() && re->Match(piece, pos, text.size(), RE2::UNANCHORED, &match, 1)) {
+                std::size_t offset = static_cast<std::size_t>(match.data() - text.data());
+                spans.push_back({static_cast<std::size_t>(index), offset, match.size()});
+                // Step past empty matches so the scan always advances
+                pos = offset + std::max<std::size_t>(match.size(), 1);
+            }
+        }
+        
+        std::sort(spans.begin(), spans.end(), [](const MatchSpan& a, const MatchSpan& b) {
+            return a.offset != b.offset ? a.offset < b.offset : a.patternIndex < b.patternIndex;
+        });
+        return spans;
+    }
+    
+    std::size_t precompilePatterns(const std::vector<std::string>& patterns) {
+        std::size_t compiled = 0;
+        for (const auto& pattern : patterns) {
+            if (regexCache_.get(pattern, RE2::DefaultOptions)->ok()) {
+                compiled++;
+            } else {
+                logger_->error("Invalid regex pattern: {}", pattern);
+            }
+        }
+        return compiled;
+    }
+    
+    RegexCacheStats regexCacheStats() const {
+        return regexCache_.stats();
+    }
+    
+    // Image Processing
+    bool processImage(const std::string& imagePath, ImageInfo& info) {
+        ScopedOp op(stats_, StatOp::Image);
+        ImageResult result = transcodeImage(imagePath, std::string(), ImageOptions{}, &info);
+        if (!result.ok) {
+            op.fail();
+            logger_->error("Failed to decode image: {}", result.error);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Decoded {}x{} image: {}", info.width, info.height, imagePath);
+        return true;
+    }
+    
+    ImageResult convertImageFormat(const std::string& inputPath, const std::string& outputPath,
+                                   const ImageOptions& options) {
+        ScopedOp op(stats_, StatOp::Image);
+        ImageResult result = transcodeImage(inputPath, outputPath, options, nullptr);
+        if (!result.ok) {
+            op.fail();
+            logger_->error("Failed to convert image: {}", result.error);
+            return result;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Converted image: {} -> {} ({}x{})", inputPath, outputPath,
+                            result.output.width, result.output.height);
+        return result;
+    }
+    
+    std::vector<ImageResult> convertImages(const std::vector<std::pair<std::string, std::string>>& jobs,
+                                           const ImageOptions& options) {
+        std::vector<ImageResult> results;
+        results.reserve(jobs.size());
+        std::size_t failed = 0;
+        // Waiting on image tasks from a pool thread could starve the pool
+        if (pool_.onWorkerThread()) {
+            for (const auto& job : jobs) {
+                results.push_back(convertImageFormat(job.first, job.second, options));
+                failed += results.back().ok ? 0 : 1;
+            }
+        } else {
+            std::vector<std::future<ImageResult>> pending;
+            pending.reserve(jobs.size());
+            for (const auto& job : jobs) {
+                pending.push_back(pool_.submit([this, &job, &options]() {
+                    return convertImageFormat(job.first, job.second, options);
+                }));
+            }
+            for (auto& future : pending) {
+                results.push_back(future.get());
+                failed += results.back().ok ? 0 : 1;
+            }
+        }
+        if (failed > 0) {
+            logger_->error("Failed to convert {} of {} images", failed, jobs.size());
+        }
+        return results;
+    }
+    
+    FreeTypeLibrary* textLibrary() {
+        if (!hasFeature(features_, Feature::Text)) {
+            logger_->error("Text feature is disabled for this processor");
+            return nullptr;
+        }
+        FreeTypeLibrary* library = freeTypeLibrary();
+        if (!library) {
+            logger_->error("Failed to initialize FreeType");
+        }
+        return library;
+    }
+    
+    bool renderText(const std::string& text, const std::string& fontPath, const std::string& outputPath,
+                    const TextOptions& options) {
+        ScopedOp op(stats_, StatOp::Text);
+        std::shared_ptr<FontFace> face;
+        std::shared_ptr<const ShapedRun> run = shapeText(text, fontPath, options, face);
+        if (!run) {
+            op.fail();
+            return false;
+        }
+        const auto extent = textExtent(*run, options.padding);
+        const int width = extent.first;
+        const int height = extent.second;
+        
+        // Coverage canvas; written inverted so text is black on white
+        std::vector<unsigned char> canvas(static_cast<std::size_t>(width) * height, 0);
+        auto blit = [&](int left, int top, int w, int h, auto&& rowAt) {
+            std::vector<unsigned char> row(static_cast<std::size_t>(w));
+            for (int y = 0; y < h; ++y) {
+                const int cy = top + y;
+                if (cy < 0 || cy >= height) {
+                    continue;
+                }
+                const unsigned char* src = rowAt(y, row.data());
+                unsigned char* dst = canvas.data() + static_cast<std::size_t>(cy) * width;
+                for (int x = 0; x < w; ++x) {
+                    const int cx = left + x;
+                    if (cx >= 0 && cx < width) {
+                        dst[cx] = std::max(dst[cx], src[x]);
+                    }
+                }
+            }
+        };
+        {
+            std::lock_guard<std::mutex> lock(face->mutex);
+            if (!face->setPixelSize(options.pixelSize)) {
+                op.fail();
+                logger_->error("Unsupported pixel size {} for font: {}", options.pixelSize, fontPath);
+                return false;
+            }
+            std::int64_t pen = static_cast<std::int64_t>(options.padding) * 64;
+            const int baseline = options.padding + run->ascender;
+            for (const ShapedRun::Placement& placement : run->glyphs) {
+                const int penX = static_cast<int>((pen + placement.xOffset) >> 6);
+                const int penY = baseline - static_cast<int>(placement.yOffset >> 6);
+                pen += placement.xAdvance;
+                
+                bool failed = false;
+                const GlyphAtlas::Glyph* glyph = face->glyph(placement.glyph, failed);
+                if (glyph) {
+                    const unsigned char* page = face->atlas().page(glyph->page);
+                    blit(penX + glyph->left, penY - glyph->top, glyph->width, glyph->height,
+                         [&](int y, unsigned char*) {
+                             return page + static_cast<std::size_t>(glyph->y + y) * GlyphAtlas::kPageSize + glyph->x;
+                         });
+                } else if (!failed) {
+                    const FT_GlyphSlot slot = face->rendered();
+                    blit(penX + slot->bitmap_left, penY - slot->bitmap_top, static_cast<int>(slot->bitmap.width),
+                         static_cast<int>(slot->bitmap.rows), [&](int y, unsigned char* scratch) {
+                             GlyphAtlas::copyCoverage(slot->bitmap, y, scratch);
+                             return static_cast<const unsigned char*>(scratch);
+                         });
+                }
+            }
+        }
+        
+        FilePtr output(std::fopen(outputPath.c_str(), "wb"), std::fclose);
+        if (!output) {
+            op.fail();
+            logger_->error("Failed to open file for writing: {}", outputPath);
+            return false;
+        }
+        std::string error;
+        bool ok;
+        {
+            PngWriter writer(output.get());
+            std::vector<unsigned char> row(static_cast<std::size_t>(width));
+            ok = writer.start(width, height, 1);
+            for (int y = 0; ok && y < height; ++y) {
+                const unsigned char* src = canvas.data() + static_cast<std::size_t>(y) * width;
+                std::transform(src, src + width, row.begin(), [](unsigned char c) { return 255 - c; });
+                ok = writer.writeRow(row.data());
+            }
+            ok = ok && writer.finish();
+            error = writer.error();
+        }
+        ok = std::fclose(output.release()) == 0 && ok;
+        if (!ok) {
+            op.fail();
+            boost::system::error_code ec;
+            fs::remove(outputPath, ec);
+            logger_->error("Failed to write rendered text to {}: {}", outputPath, error.empty() ? "write failed" : error);
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Rendered {} glyphs ({}x{}) to {}", run->glyphs.size(), width, height, outputPath);
+        return true;
+    }
+    
+    bool processTextLayout(const std::string& text, const std::string& fontPath, const TextOptions& options,
+                           TextLayout& layout) {
+        ScopedOp op(stats_, StatOp::Text);
+        std::shared_ptr<FontFace> face;
+        std::shared_ptr<const ShapedRun> run = shapeText(text, fontPath, options, face);
+        if (!run) {
+            op.fail();
+            return false;
+        }
+        const auto extent = textExtent(*run, options.padding);
+        layout.width = extent.first;
+        layout.height = extent.second;
+        layout.glyphs = run->glyphs.size();
+        return true;
+    }
+    
+    TextCacheStats textCacheStats() const {
+        TextCacheStats result;
+        const CacheCounters shapes = shapeCache_.counters();
+        result.shapeHits = shapes.hits;
+        result.shapeMisses = shapes.misses;
+        
+        std::vector<std::shared_ptr<FontFace>> faces;
+        {
+            std::lock_guard<std::mutex> lock(textMutex_);
+            for (const auto& entry : faces_) {
+                faces.push_back(entry.second);
+            }
+        }
+        result.faces = faces.size();
+        for (const auto& face : faces) {
+            std::lock_guard<std::mutex> lock(face->mutex);
+            result.glyphHits += face->atlas().hits();
+            result.glyphMisses += face->atlas().misses();
+            result.atlasPages += face->atlas().pageCount();
+        }
+        return result;
+    }
+    
+    // Cryptography with OpenSSL
+    // Legacy AES-256-CBC with a zero IV, kept for data already written in
+    // this format; new code should use CipherSession (AES-256-GCM).
+    bool encryptData(std::string_view data, std::string_view key, std::string& output) {
+        if (!cbcCrypt(data, key, true, output)) {
+            logger_->error("Failed to encrypt data");
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Data encrypted successfully");
+        return true;
+    }
+    
+    bool decryptData(std::string_view encryptedData, std::string_view key, std::string& output) {
+        if (!cbcCrypt(encryptedData, key, false, output)) {
+            logger_->error("Failed to decrypt data");
+            return false;
+        }
+        SPDLOG_LOGGER_TRACE(logger_, "Data decrypted successfully");
+        return true;
+    }
+    
+    bool generateHash(std::string_view data, Sha256Hex& hex) {
+        ScopedOp op(stats_, StatOp::Hash);
+        Sha256Digest digest;
+        if (!hashOnThreadContext(data, digest)) {
+            op.fail();
+            logger_->error("Failed to generate hash");
+            return false;
+        }
+        
+        hex = Hasher::toHex(digest);
+        SPDLOG_LOGGER_TRACE(logger_, "Hash generated successfully");
+        return true;
+    }
+    
+    std::string generateHash(std::string_view data) {
+        Sha256Hex hex;
+        return generateHash(data, hex) ? std::string(hex.data(), hex.size()) : std::string();
+    }
+    
+    std::vector<Sha256Digest> generateHashes(const std::vector<std::string>& inputs) {
+        ScopedOp op(stats_, StatOp::Hash);
+        op.items(inputs.size());
+        std::vector<Sha256Digest> digests(inputs.size());
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            if (!hashOnThreadContext(inputs[i], digests[i])) {
+                op.fail();
+                logger_->error("Failed to generate hash for input {}", i);
+                return {};
+            }
+        }
+        return digests;
+    }
+    
+    std::string hashFile(const std::string& path) {
+        ScopedOp op(stats_, StatOp::Hash);
+        MappedBuffer file(path);
+        if (!file.ok()) {
+            op.fail();
+            logger_->error("Failed to map file for hashing: {}", path);
+            return "";
+        }
+        return hashMapped(file, path, op);
+    }
+    
+    std::string hashFile(const MappedBuffer& file) {
+        ScopedOp op(stats_, StatOp::Hash);
+        return hashMapped(file, "mapped buffer", op);
+    }
+    
+    std::string hashMapped(const MappedBuffer& file, const std::string& source, ScopedOp& op) {
+        Sha256Digest digest;
+        if (!file.ok() || !hashOnThreadContext(file.view(), digest)) {
+            op.fail();
+            logger_->error("Failed to hash file: {}", source);
+            return "";
+        }
+        
+        Sha256Hex hex = Hasher::toHex(digest);
+        return std::string(hex.data(), hex.size());
     }
     
-    ~Impl() {
-        cleanupComponents();
+    // Threading
+    // Takes both by value so the public overloads can move into the task
+    std::future<void> processDataAsync(std::string data, std::function<void(const std::string&)> callback) {
+        std::uint64_t epoch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++inFlight_;
+            ++queuedAsync_;
+            epoch = cancelEpoch_;
+        }
+        return pool_.submit([this, data = std::move(data), callback = std::move(callback), epoch]() {
+            AsyncScope scope(*this);
+            if (!beginAsync(epoch)) {
+                throw std::future_error(std::future_errc::broken_promise);
+            }
+            SPDLOG_LOGGER_TRACE(logger_, "Processing data asynchronously");
+            std::string result = generateHash(data);
+            callback(result);
+        });
     }
     
-    // JSON Processing
-    bool processJsonData(const std::string& jsonData) {
-        try {
-            auto j = json::parse(jsonData);
-            logger_->info("Successfully parsed JSON data with {} elements", j.size());
-            return true;
-        } catch (const json::exception& e) {
-            logger_->error("JSON parsing error: {}", e.what());
+    void waitForCompletion() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return inFlight_ == 0; });
+    }
+    
+    bool waitForCompletion(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this]() { return inFlight_ == 0; });
+    }
+    
+    std::size_t cancelPending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t cancelled = queuedAsync_;
+        queuedAsync_ = 0;
+        ++cancelEpoch_;
+        if (cancelled > 0) {
+            logger_->info("Cancelled {} pending async operations", cancelled);
+        }
+        return cancelled;
+    }
+    
+    std::size_t pendingOperations() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inFlight_;
+    }
+    
+    // Logging
+    void setLogLevel(int level) {
+        if (logger_) {
+            logger_->set_level(static_cast<spdlog::level::level_enum>(level));
+        }
+    }
+    
+    void logOperation(const std::string& operation, const std::string& details) {
+        if (logger_) {
+            logger_->info("Operation: {} - Details: {}", operation, details);
+        }
+    }
+    
+    std::string getLastError() const {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        return lastError_;
+    }
+    
+    bool hasErrors() const {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        return !lastError_.empty();
+    }
+    
+    void clearErrors() {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        lastError_.clear();
+    }
+
+private:
+    // Marks the end of one async operation, however it exits
+    struct AsyncScope {
+        explicit AsyncScope(Impl& impl) : impl_(impl) {}
+        ~AsyncScope() { impl_.finishAsync(); }
+        Impl& impl_;
+    };
+    
+    // Returns false when the operation was cancelled while still queued
+    bool beginAsync(std::uint64_t epoch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (epoch != cancelEpoch_) {
             return false;
         }
+        --queuedAsync_;
+        return true;
     }
     
-    std::string generateJsonReport() const {
-        json report;
-        report["timestamp"] = pt::to_iso_string(pt::second_clock::universal_time());
-        report["status"] = "success";
-        report["processed_items"] = processedItems_;
-        report["errors"] = errorCount_;
-        return report.dump(2);
+    void finishAsync() {
+        bool drained;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drained = --inFlight_ == 0;
+        }
+        if (drained) {
+            cv_.notify_all();
+        }
     }
     
-    // File System Operations
-    bool processFilesInDirectory(const std::string& directoryPath) {
-        try {
-            fs::path dir(directoryPath);
-            if (!fs::exists(dir) || !fs::is_directory(dir)) {
-                logger_->error("Directory does not exist: {}", directoryPath);
-                return false;
+    // Lists one directory. With fanOut each subdirectory becomes its own
+    // pool task; otherwise the walk recurses on the calling thread. File
+    // types come from the cached directory_entry status, which readdir
+    // fills in on most filesystems, so plain files cost no extra stat.
+    void scanDirectory(const std::shared_ptr<DirectoryScan>& scan, const fs::path& dir, bool fanOut) {
+        struct Leave {
+            ~Leave() { if (scan) scan->leave(); }
+            DirectoryScan* scan;
+        } leave{fanOut ? scan.get() : nullptr};
+        
+        scan->directories++;
+        boost::system::error_code ec;
+        fs::directory_iterator it(dir, ec);
+        if (ec) {
+            scan->addError(dir.string() + ": " + ec.message());
+            return;
+        }
+        
+        for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+            if (ec) {
+                scan->addError(dir.string() + ": " + ec.message());
+                return;
             }
-            
-            int fileCount = 0;
-            for (const auto& entry : fs::recursive_directory_iterator(dir)) {
-                if (fs::is_regular_file(entry)) {
-                    fileCount++;
-                    logger_->debug("Processing file: {}", entry.path().string());
+            const fs::directory_entry& entry = *it;
+            fs::file_type type = entry.symlink_status(ec).type();
+            if (type == fs::directory_file) {
+                if (fanOut) {
+                    scan->enter();
+                    fs::path subdir = entry.path();
+                    pool_.submit([this, scan, subdir]() { scanDirectory(scan, subdir, true); });
+                } else {
+                    scanDirectory(scan, entry.path(), false);
                 }
+                continue;
+            }
+            // Symlinked files count like the recursive iterator did;
+            // symlinked directories are not followed
+            if (type == fs::symlink_file) {
+                type = entry.status(ec).type();
+            }
+            if (type != fs::regular_file) {
+                continue;
             }
             
-            logger_->info("Processed {} files in directory: {}", fileCount, directoryPath);
-            return true;
-        } catch (const fs::filesystem_error& e) {
-            logger_->error("Filesystem error: {}", e.what());
-            return false;
+            scan->files++;
+            if (scan->visitor) {
+                try {
+                    scan->visitor(entry.path().string());
+                } catch (const std::exception& e) {
+                    scan->addError(entry.path().string() + ": " + e.what());
+                }
+            }
         }
     }
     
-    bool compressFile(const std::string& inputPath, const std::string& outputPath) {
-        std::ifstream input(inputPath, std::ios::binary);
-        std::ofstream output(outputPath, std::ios::binary);
-        
-        if (!input || !output) {
-            logger_->error("Failed to open files for compression");
+    HttpClient* httpClient() {
+        if (!hasFeature(features_, Feature::Network)) {
+            logger_->error("Network feature is disabled for this processor");
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(httpMutex_);
+        if (!httpClient_ && curlGlobal()) {
+            httpClient_ = std::make_unique<HttpClient>(httpOptions_);
+            if (!httpClient_->ok()) {
+                httpClient_.reset();
+            }
+        }
+        return httpClient_.get();
+    }
+    
+    HttpResponse fetchToFile(HttpClient& client, const HttpRequest& request, const std::string& localPath,
+                             std::ios::openmode mode) {
+        std::ofstream output(localPath, std::ios::binary | mode);
+        if (!output) {
+            HttpResponse failed;
+            failed.error = "Failed to open file for writing: " + localPath;
+            return failed;
+        }
+        HttpResponse response = client.fetch(request, [&output](std::string_view chunk) {
+            output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            return static_cast<bool>(output);
+        }).get();
+        output.close();
+        if (response.ok && !output) {
+            response.ok = false;
+            response.error = "Failed to write file: " + localPath;
+        }
+        return response;
+    }
+    
+    // Fetches [0, length) as count concurrent byte ranges, each written at
+    // its offset of the pre-sized file. Fails if any range comes back short,
+    // long or as a full 200 response.
+    bool downloadSegments(HttpClient& client, const std::string& url, const std::string& localPath,
+                          std::int64_t length, std::size_t count) {
+        {
+            std::ofstream create(localPath, std::ios::binary | std::ios::trunc);
+            if (!create) {
+                logger_->error("Failed to open file for writing: {}", localPath);
+                return false;
+            }
+        }
+        boost::system::error_code ec;
+        fs::resize_file(localPath, static_cast<std::uintmax_t>(length), ec);
+        if (ec) {
+            logger_->error("Failed to size download file {}: {}", localPath, ec.message());
             return false;
         }
         
-        // Use zlib for compression
-        const int CHUNK = 16384;
-        unsigned char in[CHUNK];
-        unsigned char out[CHUNK];
-        
-        z_stream strm;
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
+        struct Segment {
+            std::fstream output;
+            std::int64_t expected = 0;
+            std::int64_t received = 0;
+            std::future<HttpResponse> response;
+        };
+        std::vector<Segment> segments(count);
+        const std::int64_t step = length / static_cast<std::int64_t>(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Segment& segment = segments[i];
+            const std::int64_t first = static_cast<std::int64_t>(i) * step;
+            const std::int64_t last = i + 1 == count ? length - 1 : first + step - 1;
+            segment.expected = last - first + 1;
+            segment.output.open(localPath, std::ios::binary | std::ios::in | std::ios::out);
+            segment.output.seekp(first);
+            if (!segment.output) {
+                continue;
+            }
+            HttpRequest request{url};
+            request.range = std::to_string(first) + "-" + std::to_string(last);
+            segment.response = client.fetch(request, [&segment](std::string_view chunk) {
+                if (segment.received + static_cast<std::int64_t>(chunk.size()) > segment.expected) {
+                    return false;
+                }
+                segment.output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                segment.received += static_cast<std::int64_t>(chunk.size());
+                return static_cast<bool>(segment.output);
+            });
+        }
         
-        if (deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
-            logger_->error("Failed to initialize zlib compression");
+        bool ok = true;
+        for (Segment& segment : segments) {
+            if (!segment.response.valid()) {
+                ok = false;
+                continue;
+            }
+            HttpResponse response = segment.response.get();
+            segment.output.close();
+            ok = ok && response.ok && response.status != 200 && segment.received == segment.expected && !segment.output.fail();
+        }
+        return ok;
+    }
+    
+    // Block tasks are waited on by the caller; from a pool thread that
+    // could starve the pool, so such callers deflate and seal inline
+    WorkerPool* sealingPool(const CompressionOptions& options) {
+        return options.parallel && !pool_.onWorkerThread() ? &pool_ : nullptr;
+    }
+    
+    // Body chunks a sealed download may queue ahead of its sealing thread
+    // before its transfer is paused; curl hands over at most 16 KiB per call
+    static constexpr std::size_t kSealedDownloadQueue = 256;
+    
+    static constexpr std::size_t kJsonReadSize = 1 << 20;
+    
+    static constexpr std::size_t kJsonBatchMinPiece = 64 * 1024;
+    static constexpr std::size_t kJsonBatchMaxPiece = 8 << 20;
+    
+    bool finishJsonLines(ScopedOp& op, const std::string& firstError, const JsonStreamResult& result,
+                         const std::string& source) {
+        op.items(result.records);
+        op.fail(result.errors);
+        if (result.errors > 0) {
+            logger_->error("JSON lines from {}: {} records, {} malformed (first at {})",
+                           source, result.records, result.errors, firstError);
             return false;
         }
-        
-        do {
-            input.read(reinterpret_cast<char*>(in), CHUNK);
-            strm.avail_in = input.gcount();
-            strm.next_in = in;
-            
-            do {
-                strm.avail_out = CHUNK;
-                strm.next_out = out;
-                deflate(&strm, input.eof() ? Z_FINISH : Z_NO_FLUSH);
-                
-                int have = CHUNK - strm.avail_out;
-                output.write(reinterpret_cast<char*>(out), have);
-            } while (strm.avail_out == 0);
-        } while (!input.eof());
-        
-        deflateEnd(&strm);
-        logger_->info("Successfully compressed file: {} -> {}", inputPath, outputPath);
+        SPDLOG_LOGGER_TRACE(logger_, "Successfully parsed {} JSON records from {}", result.records, source);
         return true;
     }
     
-    // Database Operations
-    bool initializeDatabase(const std::string& dbPath) {
-        if (sqlite3_open(dbPath.c_str(), &db_) != SQLITE_OK) {
-            logger_->error("Failed to open database: {}", dbPath);
+    // Runs the legacy CBC transform on a per-thread context, writing
+    // straight into output and reusing its capacity
+    static bool cbcCrypt(std::string_view input, std::string_view key, bool encrypt, std::string& output) {
+        if (key.size() < CipherSession::kKeySize || input.size() > static_cast<std::size_t>(INT_MAX - EVP_MAX_BLOCK_LENGTH)) {
             return false;
         }
-        
-        const char* sql = "CREATE TABLE IF NOT EXISTS data_processor_logs ("
-                         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-                         "timestamp TEXT NOT NULL,"
-                         "operation TEXT NOT NULL,"
-                         "details TEXT"
-                         ");";
-        
-        char* errMsg = 0;
-        if (sqlite3_exec(db_, sql, 0, 0, &errMsg) != SQLITE_OK) {
-            logger_->error("SQL error: {}", errMsg);
-            sqlite3_free(errMsg);
+        thread_local std::unique_ptr<EVP_CIPHER_CTX, void (*)(EVP_CIPHER_CTX*)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+        if (!ctx || EVP_CipherInit_ex(ctx.get(), EVP_aes_256_cbc(), nullptr,
+                                      reinterpret_cast<const unsigned char*>(key.data()), nullptr, encrypt) != 1) {
             return false;
         }
         
-        logger_->info("Database initialized successfully: {}", dbPath);
+        output.resize(input.size() + EVP_MAX_BLOCK_LENGTH);
+        auto* out = reinterpret_cast<unsigned char*>(&output[0]);
+        int len = 0;
+        int finalLen = 0;
+        if (EVP_CipherUpdate(ctx.get(), out, &len, reinterpret_cast<const unsigned char*>(input.data()),
+                             static_cast<int>(input.size())) != 1 ||
+            EVP_CipherFinal_ex(ctx.get(), out + len, &finalLen) != 1) {
+            output.clear();
+            return false;
+        }
+        output.resize(static_cast<std::size_t>(len + finalLen));
         return true;
     }
     
-    bool storeData(const std::string& table, const std::string& data) {
-        if (!db_) {
-            logger_->error("Database not initialized");
+    // Decompression helpers. Both accept concatenated members/streams, as
+    // produced by pigz and pbzip2.
+    static constexpr std::size_t kDecompressReadSize = 1 << 20;
+    static constexpr std::size_t kDecompressOutSize = 256 * 1024;
+    
+    static bool inflateStream(ReadAhead& reader, std::string_view chunk, const ChunkSink& sink) {
+        z_stream strm{};
+        // 15 + 32: accept both zlib and gzip headers
+        if (inflateInit2(&strm, 15 + 32) != Z_OK) {
             return false;
         }
         
-        std::string sql = fmt::format("INSERT INTO {} (timestamp, operation, details) VALUES (?, ?, ?)", table);
-        sqlite3_stmt* stmt;
+        std::vector<char> out(kDecompressOutSize);
+        int ret = Z_OK;
+        for (; !chunk.empty(); chunk = reader.next()) {
+            strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+            strm.avail_in = static_cast<uInt>(chunk.size());
+            do {
+                if (ret == Z_STREAM_END) {
+                    if (strm.avail_in == 0) {
+                        break;
+                    }
+                    inflateReset(&strm);
+                }
+                strm.next_out = reinterpret_cast<Bytef*>(out.data());
+                strm.avail_out = static_cast<uInt>(out.size());
+                ret = inflate(&strm, Z_NO_FLUSH);
+                if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                    inflateEnd(&strm);
+                    return false;
+                }
+                std::size_t have = out.size() - strm.avail_out;
+                if (have > 0 && !sink(std::string_view(out.data(), have))) {
+                    inflateEnd(&strm);
+                    return false;
+                }
+            } while (strm.avail_out == 0 || (ret == Z_STREAM_END && strm.avail_in > 0));
+        }
         
-        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            logger_->error("Failed to prepare SQL statement");
+        inflateEnd(&strm);
+        return ret == Z_STREAM_END;
+    }
+    
+    static bool bunzipStream(ReadAhead& reader, std::string_view chunk, const ChunkSink& sink) {
+        bz_stream strm{};
+        if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
             return false;
         }
         
-        std::string timestamp = pt::to_iso_string(pt::second_clock::universal_time());
-        sqlite3_bind_text(stmt, 1, timestamp.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, "data_storage", -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, data.c_str(), -1, SQLITE_STATIC);
-        
-        bool success = sqlite3_step(stmt) == SQLITE_DONE;
-        sqlite3_finalize(stmt);
-        
-        if (success) {
-            logger_->info("Data stored successfully in table: {}", table);
-        } else {
-            logger_->error("Failed to store data in table: {}", table);
+        std::vector<char> out(kDecompressOutSize);
+        int ret = BZ_OK;
+        for (; !chunk.empty(); chunk = reader.next()) {
+            strm.next_in = const_cast<char*>(chunk.data());
+            strm.avail_in = static_cast<unsigned int>(chunk.size());
+            do {
+                if (ret == BZ_STREAM_END) {
+                    if (strm.avail_in == 0) {
+                        break;
+                    }
+                    char* nextIn = strm.next_in;
+                    unsigned int availIn = strm.avail_in;
+                    BZ2_bzDecompressEnd(&strm);
+                    strm = bz_stream{};
+                    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+                        return false;
+                    }
+                    strm.next_in = nextIn;
+                    strm.avail_in = availIn;
+                }
+                strm.next_out = out.data();
+                strm.avail_out = static_cast<unsigned int>(out.size());
+                ret = BZ2_bzDecompress(&strm);
+                if (ret != BZ_OK && ret != BZ_STREAM_END) {
+                    BZ2_bzDecompressEnd(&strm);
+                    return false;
+                }
+                std::size_t have = out.size() - strm.avail_out;
+                if (have > 0 && !sink(std::string_view(out.data(), have))) {
+                    BZ2_bzDecompressEnd(&strm);
+                    return false;
+                }
+            } while (strm.avail_out == 0 || (ret == BZ_STREAM_END && strm.avail_in > 0));
         }
         
-        return success;
+        BZ2_bzDecompressEnd(&strm);
+        return ret == BZ_STREAM_END;
     }
     
-    // Network Operations
-    bool downloadFile(const std::string& url, const std::string& localPath) {
-        if (!curl_) {
-            logger_->error("CURL not initialized");
-            return false;
+    bool writeIndexUpdates(const std::vector<IndexUpdate>& updates, const std::vector<std::string>& removed) {
+        if (updates.empty() && removed.empty()) {
+            return true;
         }
         
-        FILE* fp = fopen(localPath.c_str(), "wb");
-        if (!fp) {
-            logger_->error("Failed to open file for writing: {}", localPath);
+        std::lock_guard<std::mutex> lock(dbMutex_);
+        sqlite3_stmt* upsert = nullptr;
+        sqlite3_stmt* erase = nullptr;
+        const char* upsertSql = "INSERT OR REPLACE INTO file_index (path, size, mtime, hash, indexed_at) "
+                                "VALUES (?, ?, ?, ?, ?)";
+        if (sqlite3_prepare_v2(db_, upsertSql, -1, &upsert, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db_, "DELETE FROM file_index WHERE path = ?", -1, &erase, nullptr) != SQLITE_OK) {
+            logger_->error("Failed to prepare file index statements: {}", sqlite3_errmsg(db_));
+            sqlite3_finalize(upsert);
             return false;
         }
+        std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)> upsertGuard(upsert, sqlite3_finalize);
+        std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt*)> eraseGuard(erase, sqlite3_finalize);
         
-        curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, nullptr);
-        curl_easy_setopt(curl_, CURLOPT_WRITEDATA, fp);
-        curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 30L);
+        if (!execSql("BEGIN IMMEDIATE;")) {
+            return false;
+        }
         
-        CURLcode res = curl_easy_perform(curl_);
-        fclose(fp);
+        std::string timestamp = currentTimestamp();
+        bool ok = true;
+        for (const auto& update : updates) {
+            sqlite3_bind_text(upsert, 1, update.path.c_str(), static_cast<int>(update.path.size()), SQLITE_STATIC);
+            sqlite3_bind_int64(upsert, 2, update.size);
+            sqlite3_bind_int64(upsert, 3, update.mtime);
+            sqlite3_bind_text(upsert, 4, update.hash.c_str(), static_cast<int>(update.hash.size()), SQLITE_STATIC);
+            sqlite3_bind_text(upsert, 5, timestamp.c_str(), static_cast<int>(timestamp.size()), SQLITE_STATIC);
+            ok = ok && sqlite3_step(upsert) == SQLITE_DONE;
+            sqlite3_reset(upsert);
+        }
+        for (const auto& path : removed) {
+            sqlite3_bind_text(erase, 1, path.c_str(), static_cast<int>(path.size()), SQLITE_STATIC);
+            ok = ok && sqlite3_step(erase) == SQLITE_DONE;
+            sqlite3_reset(erase);
+        }
         
-        if (res != CURLE_OK) {
-            logger_->error("CURL error: {}", curl_easy_strerror(res));
+        if (!ok || !execSql("COMMIT;")) {
+            logger_->error("Failed to update file index: {}", sqlite3_errmsg(db_));
+            execSql("ROLLBACK;");
             return false;
         }
-        
-        logger_->info("Successfully downloaded file: {} -> {}", url, localPath);
         return true;
     }
     
-    // Text Processing with RE2
-    bool processTextWithRegex(const std::string& text, const std::string& pattern) {
-        RE2 re(pattern);
-        if (!re.ok()) {
-            logger_->error("Invalid regex pattern: {}", pattern);
+    // Binds params and steps stmt, passing each row to visitor. With a lock,
+    // it is released for a moment every pageSize rows.
+    bool runQuery(sqlite3_stmt* stmt, sqlite3* db, const std::vector<std::string>& params,
+                  const RowVisitor& visitor, std::unique_lock<std::mutex>* lock, std::size_t pageSize) {
+        if (static_cast<std::size_t>(sqlite3_bind_parameter_count(stmt)) != params.size()) {
+            logger_->error("Query expects {} parameters, got {}", sqlite3_bind_parameter_count(stmt), params.size());
             return false;
         }
-        
-        std::string match;
-        if (RE2::PartialMatch(text, re, &match)) {
-            logger_->info("Found match: {}", match);
-            return true;
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            sqlite3_bind_text(stmt, static_cast<int>(i + 1), params[i].data(),
+                              static_cast<int>(params[i].size()), SQLITE_STATIC);
         }
         
-        logger_->info("No match found for pattern: {}", pattern);
-        return false;
+        std::size_t rowsInPage = 0;
+        QueryRow row(stmt);
+        while (true) {
+            int rc = sqlite3_step(stmt);
+            if (rc == SQLITE_DONE) {
+                break;
+            }
+            if (rc != SQLITE_ROW) {
+                logger_->error("Query failed: {}", sqlite3_errmsg(db));
+                return false;
+            }
+            if (!visitor(row)) {
+                break;
+            }
+            if (lock && ++rowsInPage == pageSize) {
+                rowsInPage = 0;
+                lock->unlock();
+                std::this_thread::yield();
+                lock->lock();
+            }
+        }
+        return true;
     }
     
-    // Cryptography with OpenSSL
-    std::string encryptData(const std::string& data, const std::string& key) {
-        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-        if (!ctx) {
-            logger_->error("Failed to create cipher context");
-            return "";
-        }
-        
-        if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, 
-                              reinterpret_cast<const unsigned char*>(key.c_str()), nullptr) != 1) {
-            logger_->error("Failed to initialize encryption");
-            EVP_CIPHER_CTX_free(ctx);
-            return "";
-        }
-        
-        std::vector<unsigned char> encrypted(data.size() + EVP_MAX_BLOCK_LENGTH);
-        int len;
-        
-        if (EVP_EncryptUpdate(ctx, encrypted.data(), &len, 
-                             reinterpret_cast<const unsigned char*>(data.c_str()), data.size()) != 1) {
-            logger_->error("Failed to encrypt data");
-            EVP_CIPHER_CTX_free(ctx);
-            return "";
-        }
-        
-        int finalLen;
-        EVP_EncryptFinal_ex(ctx, encrypted.data() + len, &finalLen);
-        EVP_CIPHER_CTX_free(ctx);
-        
-        std::string result(reinterpret_cast<char*>(encrypted.data()), len + finalLen);
-        logger_->info("Data encrypted successfully");
-        return result;
+    static int resetStatement(sqlite3_stmt* stmt) {
+        sqlite3_reset(stmt);
+        return sqlite3_clear_bindings(stmt);
     }
     
-    std::string generateHash(const std::string& data) {
-        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-        if (!ctx) {
-            logger_->error("Failed to create hash context");
-            return "";
+    // Checks out an idle read connection for the lifetime of the lease,
+    // waiting if all of them are busy
+    class ReaderLease {
+    public:
+        explicit ReaderLease(Impl& impl) : impl_(impl) {
+            std::unique_lock<std::mutex> lock(impl_.readerMutex_);
+            impl_.readerAvailable_.wait(lock, [this]() { return !impl_.idleReaders_.empty(); });
+            connection_ = impl_.idleReaders_.back();
+            impl_.idleReaders_.pop_back();
         }
         
-        if (EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1) {
-            logger_->error("Failed to initialize hash");
-            EVP_MD_CTX_free(ctx);
-            return "";
-        }
-        
-        if (EVP_DigestUpdate(ctx, data.c_str(), data.size()) != 1) {
-            logger_->error("Failed to update hash");
-            EVP_MD_CTX_free(ctx);
-            return "";
+        ~ReaderLease() {
+            {
+                std::lock_guard<std::mutex> lock(impl_.readerMutex_);
+                impl_.idleReaders_.push_back(connection_);
+            }
+            impl_.readerAvailable_.notify_one();
         }
         
-        unsigned char hash[EVP_MAX_MD_SIZE];
-        unsigned int hashLen;
-        
-        if (EVP_DigestFinal_ex(ctx, hash, &hashLen) != 1) {
-            logger_->error("Failed to finalize hash");
-            EVP_MD_CTX_free(ctx);
-            return "";
-        }
+        ReaderLease(const ReaderLease&) = delete;
+        ReaderLease& operator=(const ReaderLease&) = delete;
         
-        EVP_MD_CTX_free(ctx);
+        ReadConnection* operator->() const { return connection_; }
         
-        std::stringstream ss;
-        for (unsigned int i = 0; i < hashLen; i++) {
-            ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    private:
+        Impl& impl_;
+        ReadConnection* connection_ = nullptr;
+    };
+    
+    bool openReaders(const std::string& dbPath, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            auto reader = std::make_unique<ReadConnection>(dbPath);
+            if (!reader->ok()) {
+                logger_->error("Failed to open read connection: {}", dbPath);
+                closeReaders();
+                return false;
+            }
+            idleReaders_.push_back(reader.get());
+            readers_.push_back(std::move(reader));
         }
-        
-        logger_->info("Hash generated successfully");
-        return ss.str();
+        return true;
     }
     
-    // Threading
-    void processDataAsync(const std::string& data, std::function<void(const std::string&)> callback) {
-        std::thread([this, data, callback]() {
-            logger_->info("Processing data asynchronously");
-            std::string result = generateHash(data);
-            callback(result);
-        }).detach();
+    // Callers must not be running queries; nothing waits for leases
+    void closeReaders() {
+        std::lock_guard<std::mutex> lock(readerMutex_);
+        idleReaders_.clear();
+        readers_.clear();
     }
     
-    void waitForCompletion() {
-        // Simple wait implementation
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Database helpers. Everything touching db_ runs under dbMutex_.
+    bool execSql(const char* sql) {
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            logger_->error("SQL error: {}", errMsg ? errMsg : sqlite3_errmsg(db_));
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
     }
     
-    // Logging
-    void setLogLevel(int level) {
-        if (logger_) {
-            logger_->set_level(static_cast<spdlog::level::level_enum>(level));
+    static std::string currentTimestamp() {
+        return pt::to_iso_string(pt::second_clock::universal_time());
+    }
+    
+    // Prepared once per table and kept until the database is closed
+    sqlite3_stmt* insertStatement(const std::string& table) {
+        auto it = insertStatements_.find(table);
+        if (it != insertStatements_.end()) {
+            return it->second;
+        }
+        
+        std::string sql = fmt::format("INSERT INTO {} (timestamp, operation, details) VALUES (?, ?, ?)", table);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(db_, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            logger_->error("Failed to prepare SQL statement: {}", sqlite3_errmsg(db_));
+            return nullptr;
         }
+        insertStatements_.emplace(table, stmt);
+        return stmt;
     }
     
-    void logOperation(const std::string& operation, const std::string& details) {
-        if (logger_) {
-            logger_->info("Operation: {} - Details: {}", operation, details);
+    static bool insertRow(sqlite3_stmt* stmt, const std::string& timestamp, const std::string& data) {
+        sqlite3_bind_text(stmt, 1, timestamp.c_str(), static_cast<int>(timestamp.size()), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, "data_storage", -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, data.c_str(), static_cast<int>(data.size()), SQLITE_STATIC);
+        
+        bool success = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return success;
+    }
+    
+    // Background writer: drains writeQueue_ in groups of up to
+    // writerBatchSize_ rows, one transaction per group. Rows queued while a
+    // group is being committed form the next group.
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(writeMutex_);
+        while (true) {
+            writeCv_.wait(lock, [this]() { return !writeQueue_.empty() || writerStopping_; });
+            if (writeQueue_.empty()) {
+                return;
+            }
+            
+            std::size_t count = std::min(writeQueue_.size(), writerBatchSize_);
+            std::vector<std::pair<std::string, std::string>> group(
+                std::make_move_iterator(writeQueue_.begin()),
+                std::make_move_iterator(writeQueue_.begin() + count));
+            writeQueue_.erase(writeQueue_.begin(), writeQueue_.begin() + count);
+            writerBusy_ = true;
+            lock.unlock();
+            writeSpace_.notify_all();
+            
+            const std::size_t failed = writeGroup(group);
+            
+            lock.lock();
+            writerFailures_ += failed;
+            writerBusy_ = false;
+            if (writeQueue_.empty()) {
+                writeDrained_.notify_all();
+            }
         }
     }
     
-    std::string getLastError() const {
-        return lastError_;
+    // Returns the rows lost; they are also counted as database errors and
+    // recorded as the last error
+    std::size_t writeGroup(const std::vector<std::pair<std::string, std::string>>& group) {
+        ScopedOp op(stats_, StatOp::Database);
+        std::size_t failed = 0;
+        {
+            std::lock_guard<std::mutex> lock(dbMutex_);
+            if (!execSql("BEGIN IMMEDIATE;")) {
+                failed = group.size();
+            } else {
+                std::string timestamp = currentTimestamp();
+                for (const auto& [table, data] : group) {
+                    sqlite3_stmt* stmt = insertStatement(table);
+                    if (!stmt || !insertRow(stmt, timestamp, data)) {
+                        failed++;
+                    }
+                }
+                
+                if (!execSql("COMMIT;")) {
+                    execSql("ROLLBACK;");
+                    failed = group.size();
+                }
+            }
+        }
+        
+        op.items(group.size() - failed);
+        if (failed > 0) {
+            op.fail(failed);
+            const std::string message = fmt::format("Background writer failed to store {} of {} rows",
+                                                    failed, group.size());
+            logger_->error(message);
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            lastError_ = message;
+        }
+        return failed;
     }
     
-    bool hasErrors() const {
-        return !lastError_.empty();
+    void closeDatabase() {
+        if (dbWriter_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(writeMutex_);
+                writerStopping_ = true;
+            }
+            writeCv_.notify_one();
+            dbWriter_.join();
+        }
+        
+        closeReaders();
+        
+        std::lock_guard<std::mutex> lock(dbMutex_);
+        for (auto& entry : insertStatements_) {
+            sqlite3_finalize(entry.second);
+        }
+        insertStatements_.clear();
+        
+        if (db_) {
+            sqlite3_close(db_);
+            db_ = nullptr;
+        }
     }
     
-    void clearErrors() {
-        lastError_.clear();
-    }
-
-private:
     bool initializeComponents() {
         try {
-            // Initialize spdlog
-            logger_ = spdlog::stdout_color_mt("data_processor");
-            logger_->set_level(spdlog::level::info);
-            
-            // Initialize CURL
-            curl_global_init(CURL_GLOBAL_DEFAULT);
-            curl_ = curl_easy_init();
-            
-            // Initialize FreeType
-            if (FT_Init_FreeType(&ft_library_) != 0) {
-                logger_->error("Failed to initialize FreeType");
-                return false;
-            }
-            
-            // Initialize HarfBuzz
-            hb_font_ = hb_ft_font_create_referenced(ft_face_);
+            // Initialize spdlog. libcurl and FreeType are set up on first
+            // use; see curlGlobal() and freeTypeLibrary().
+            logger_ = createLogger(loggingOptions_);
             
             logger_->info("All components initialized successfully");
             return true;
         } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(errorMutex_);
             lastError_ = e.what();
             return false;
         }
     }
     
+    std::shared_ptr<spdlog::logger> createLogger(const LoggingOptions& options) {
+        std::shared_ptr<spdlog::logger> logger;
+        if (options.async) {
+            logPool_ = sharedLogPool(options.queueSize);
+            logger = std::make_shared<spdlog::async_logger>(
+                "data_processor", sharedConsoleSink(), logPool_,
+                options.dropOnOverflow ? spdlog::async_overflow_policy::overrun_oldest
+                                       : spdlog::async_overflow_policy::block);
+        } else {
+            logger = std::make_shared<spdlog::logger>("data_processor", sharedConsoleSink());
+        }
+        logger->set_level(static_cast<spdlog::level::level_enum>(options.level));
+        // Errors are rare and usually precede a crash or exit; don't leave
+        // them sitting in the ring
+        logger->flush_on(spdlog::level::err);
+        return logger;
+    }
+    
     void cleanupComponents() {
         if (logger_) {
             logger_->info("Cleaning up components");
+            logger_->flush();
         }
         
-        if (db_) {
-            sqlite3_close(db_);
+        closeDatabase();
+        httpClient_.reset();
+    }
+    
+    // Face for fontPath, opened on first use and kept for the processor's
+    // lifetime; null (logged) when the file can't be loaded
+    std::shared_ptr<FontFace> fontFace(const std::string& fontPath) {
+        FreeTypeLibrary* library = textLibrary();
+        if (!library) {
+            return nullptr;
         }
-        
-        if (curl_) {
-            curl_easy_cleanup(curl_);
-            curl_global_cleanup();
+        std::lock_guard<std::mutex> lock(textMutex_);
+        auto it = faces_.find(fontPath);
+        if (it != faces_.end()) {
+            return it->second;
         }
-        
-        if (hb_font_) {
-            hb_font_destroy(hb_font_);
+        std::string error;
+        std::shared_ptr<FontFace> face = FontFace::open(*library, fontPath, error);
+        if (!face) {
+            logger_->error(error);
+            return nullptr;
         }
-        
-        if (ft_face_) {
-            FT_Done_Face(ft_face_);
+        faces_.emplace(fontPath, face);
+        return face;
+    }
+    
+    // Shaped run for text at options.pixelSize, from shapeCache_ when it
+    // has been shaped before; null (logged) on failure
+    std::shared_ptr<const ShapedRun> shapeText(const std::string& text, const std::string& fontPath,
+                                               const TextOptions& options, std::shared_ptr<FontFace>& face) {
+        if (options.pixelSize <= 0 || options.padding < 0) {
+            logger_->error("Invalid text options: pixel size {}, padding {}", options.pixelSize, options.padding);
+            return nullptr;
         }
-        
-        if (ft_library_) {
-            FT_Done_FreeType(ft_library_);
+        face = fontFace(fontPath);
+        if (!face) {
+            return nullptr;
         }
+        std::string key = fmt::format("{}\n{}\n", fontPath, options.pixelSize);
+        key += text;
+        // A size the face rejects is cached as null too; it won't start working
+        auto run = shapeCache_.get(key, [&]() -> std::shared_ptr<const ShapedRun> {
+            std::lock_guard<std::mutex> lock(face->mutex);
+            if (!face->setPixelSize(options.pixelSize)) {
+                return nullptr;
+            }
+            return std::make_shared<const ShapedRun>(face->shape(text));
+        });
+        if (!run) {
+            logger_->error("Unsupported pixel size {} for font: {}", options.pixelSize, fontPath);
+            return nullptr;
+        }
+        return run;
     }
     
-    // Component instances
+    // Component instances. The log pool must outlive logger_, which only
+    // holds it weakly.
+    std::shared_ptr<spdlog::details::thread_pool> logPool_;
     std::shared_ptr<spdlog::logger> logger_;
     sqlite3* db_;
-    CURL* curl_;
-    FT_Library ft_library_;
-    FT_Face ft_face_;
-    hb_font_t* hb_font_;
+    Feature features_;
+    
+    RegexCache regexCache_;
+    
+    // Text rendering; faces_ is guarded by textMutex_
+    mutable std::mutex textMutex_;
+    std::unordered_map<std::string, std::shared_ptr<FontFace>> faces_;
+    LruCache<ShapedRun> shapeCache_;
+    
+    // HTTP client, started on first use
+    HttpOptions httpOptions_;
+    std::mutex httpMutex_;
+    std::unique_ptr<HttpClient> httpClient_;
+    
+    // Database state
+    std::mutex dbMutex_;
+    std::unordered_map<std::string, sqlite3_stmt*> insertStatements_;
+    std::thread dbWriter_;
+    std::mutex writeMutex_;
+    std::condition_variable writeCv_;
+    std::condition_variable writeDrained_;
+    std::condition_variable writeSpace_;
+    std::deque<std::pair<std::string, std::string>> writeQueue_;
+    std::size_t writerBatchSize_ = 0;
+    std::size_t writerQueueLimit_ = 1;
+    // Rows lost since the last flushWrites
+    std::size_t writerFailures_ = 0;
+    bool writerBusy_ = false;
+    bool writerStopping_ = false;
+    // Read connections for queryData; idleReaders_ is guarded by readerMutex_
+    std::vector<std::unique_ptr<ReadConnection>> readers_;
+    std::vector<ReadConnection*> idleReaders_;
+    std::mutex readerMutex_;
+    std::condition_variable readerAvailable_;
     
     // State
-    int processedItems_ = 0;
-    int errorCount_ = 0;
+    // Per-operation counters behind generateJsonReport; lock-free
+    OperationStats stats_;
+    // Latest runBatch report, guarded by batchMutex_
+    std::optional<BatchReport> lastBatch_;
+    mutable std::mutex batchMutex_;
+    LoggingOptions loggingOptions_;
+    // Guarded by errorMutex_
     std::string lastError_;
-    std::mutex mutex_;
+    mutable std::mutex errorMutex_;
+    mutable std::mutex mutex_;
     std::condition_variable cv_;
+    
+    // Async bookkeeping, guarded by mutex_. inFlight_ counts submitted but
+    // unfinished operations; queuedAsync_ counts those not yet started.
+    // Bumping cancelEpoch_ makes every queued operation skip its work.
+    std::size_t inFlight_ = 0;
+    std::size_t queuedAsync_ = 0;
+    std::uint64_t cancelEpoch_ = 0;
+    
+    // Declared last so workers are joined before the state they touch is destroyed
+    WorkerPool pool_;
+};
+
+// Hasher
+Hasher::Hasher() : ctx_(EVP_MD_CTX_new()) {
+    reset();
+}
+
+Hasher::~Hasher() {
+    EVP_MD_CTX_free(ctx_);
+}
+
+Hasher::Hasher(Hasher&& other) noexcept : ctx_(other.ctx_), ok_(other.ok_) {
+    other.ctx_ = nullptr;
+    other.ok_ = false;
+}
+
+Hasher& Hasher::operator=(Hasher&& other) noexcept {
+    if (this != &other) {
+        EVP_MD_CTX_free(ctx_);
+        ctx_ = other.ctx_;
+        ok_ = other.ok_;
+        other.ctx_ = nullptr;
+        other.ok_ = false;
+    }
+    return *this;
+}
+
+void Hasher::reset() {
+    ok_ = ctx_ && EVP_DigestInit_ex(ctx_, sha256Method(), nullptr) == 1;
+}
+
+bool Hasher::update(std::string_view data) {
+    ok_ = ok_ && EVP_DigestUpdate(ctx_, data.data(), data.size()) == 1;
+    return ok_;
+}
+
+bool Hasher::finalize(Sha256Digest& digest) {
+    unsigned int length = 0;
+    bool ok = ok_ && EVP_DigestFinal_ex(ctx_, digest.data(), &length) == 1 && length == digest.size();
+    reset();
+    return ok;
+}
+
+Sha256Hex Hasher::toHex(const Sha256Digest& digest) {
+    // Two output characters per byte value, looked up in one step
+    static constexpr auto table = []() {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char, 512> pairs{};
+        for (std::size_t i = 0; i < 256; ++i) {
+            pairs[2 * i] = digits[i >> 4];
+            pairs[2 * i + 1] = digits[i & 0x0f];
+        }
+        return pairs;
+    }();
+    
+    Sha256Hex hex;
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        hex[2 * i] = table[2 * digest[i]];
+        hex[2 * i + 1] = table[2 * digest[i] + 1];
+    }
+    return hex;
+}
+
+// MappedBuffer
+struct MappedBuffer::Region {
+    boost::interprocess::mapped_region region;
 };
 
+MappedBuffer::MappedBuffer() = default;
+
+MappedBuffer::MappedBuffer(const std::string& path) {
+    try {
+        boost::system::error_code ec;
+        const std::uintmax_t size = fs::file_size(path, ec);
+        if (ec) {
+            return;
+        }
+        if (size > 0) {
+            boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+            region_ = std::make_unique<Region>();
+            region_->region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+            region_->region.advise(boost::interprocess::mapped_region::advice_sequential);
+            data_ = static_cast<const char*>(region_->region.get_address());
+            size_ = region_->region.get_size();
+        }
+        ok_ = true;
+    } catch (const boost::interprocess::interprocess_exception&) {
+        region_.reset();
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+MappedBuffer::~MappedBuffer() = default;
+
+MappedBuffer::MappedBuffer(MappedBuffer&& other) noexcept
+    : region_(std::move(other.region_)), data_(other.data_), size_(other.size_), ok_(other.ok_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.ok_ = false;
+}
+
+MappedBuffer& MappedBuffer::operator=(MappedBuffer&& other) noexcept {
+    if (this != &other) {
+        region_ = std::move(other.region_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        ok_ = std::exchange(other.ok_, false);
+    }
+    return *this;
+}
+
+// CipherSession
+CipherSession::CipherSession(const std::string& key) : id_(nextCipherSessionId++) {
+    ok_ = key.size() == kKeySize;
+    if (ok_) {
+        std::copy(key.begin(), key.end(), key_.begin());
+    }
+}
+
+CipherSession::~CipherSession() {
+    OPENSSL_cleanse(key_.data(), key_.size());
+}
+
+bool CipherSession::newNonce(Nonce& nonce) {
+    return RAND_bytes(nonce.data(), static_cast<int>(nonce.size())) == 1;
+}
+
+bool CipherSession::crypt(bool encrypt, const Nonce& nonce, unsigned char flag, std::string_view input,
+                          unsigned char* output, unsigned char* tag) const {
+    if (!ok_) {
+        return false;
+    }
+    EVP_CIPHER_CTX* ctx = ThreadCipherContexts::current().keyed(encrypt, id_, key_.data());
+    if (!ctx || EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, nonce.data(), encrypt) != 1) {
+        return false;
+    }
+    
+    int len = 0;
+    if (EVP_CipherUpdate(ctx, nullptr, &len, &flag, 1) != 1) {
+        return false;
+    }
+    // EVP lengths are int; feed very large inputs in pieces
+    constexpr std::size_t kMaxPiece = 1u << 30;
+    const auto* in = reinterpret_cast<const unsigned char*>(input.data());
+    for (std::size_t done = 0; done < input.size(); done += kMaxPiece) {
+        int piece = static_cast<int>(std::min(kMaxPiece, input.size() - done));
+        if (EVP_CipherUpdate(ctx, output + done, &len, in + done, piece) != 1) {
+            return false;
+        }
+    }
+    
+    if (!encrypt && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(kTagSize), tag) != 1) {
+        return false;
+    }
+    if (EVP_CipherFinal_ex(ctx, output + input.size(), &len) != 1) {
+        return false;
+    }
+    return !encrypt || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(kTagSize), tag) == 1;
+}
+
+bool CipherSession::seal(std::string_view plaintext, char* output, std::size_t capacity, std::size_t& written) const {
+    written = 0;
+    if (capacity < sealedSize(plaintext.size())) {
+        return false;
+    }
+    Nonce nonce;
+    if (!newNonce(nonce)) {
+        return false;
+    }
+    auto* out = reinterpret_cast<unsigned char*>(output);
+    std::copy(nonce.begin(), nonce.end(), out);
+    if (!crypt(true, nonce, 0, plaintext, out + kNonceSize, out + kNonceSize + plaintext.size())) {
+        return false;
+    }
+    written = sealedSize(plaintext.size());
+    return true;
+}
+
+bool CipherSession::open(std::string_view sealed, char* output, std::size_t capacity, std::size_t& written) const {
+    written = 0;
+    if (sealed.size() < kNonceSize + kTagSize || capacity < sealed.size() - kNonceSize - kTagSize) {
+        return false;
+    }
+    Nonce nonce;
+    std::copy(sealed.begin(), sealed.begin() + kNonceSize, nonce.begin());
+    std::string_view ciphertext = sealed.substr(kNonceSize, sealed.size() - kNonceSize - kTagSize);
+    std::array<unsigned char, kTagSize> tag;
+    std::copy(sealed.end() - kTagSize, sealed.end(), tag.begin());
+    if (!crypt(false, nonce, 0, ciphertext, reinterpret_cast<unsigned char*>(output), tag.data())) {
+        return false;
+    }
+    written = ciphertext.size();
+    return true;
+}
+
+CipherSession::Nonce CipherSession::chunkNonce(const Nonce& streamNonce, std::uint64_t index) {
+    Nonce nonce = streamNonce;
+    for (std::size_t i = 0; i < 8; ++i) {
+        nonce[kNonceSize - 1 - i] ^= static_cast<unsigned char>(index >> (8 * i));
+    }
+    return nonce;
+}
+
+bool CipherSession::sealChunk(const Nonce& streamNonce, std::uint64_t index, bool last,
+                              std::string_view plaintext, char* output) const {
+    auto* out = reinterpret_cast<unsigned char*>(output);
+    // A distinct flag for the final chunk makes truncation detectable
+    return crypt(true, chunkNonce(streamNonce, index), last ? 1 : 2, plaintext, out, out + plaintext.size());
+}
+
+bool CipherSession::openChunk(const Nonce& streamNonce, std::uint64_t index, bool last,
+                              std::string_view sealed, char* output) const {
+    if (sealed.size() < kTagSize) {
+        return false;
+    }
+    std::string_view ciphertext = sealed.substr(0, sealed.size() - kTagSize);
+    std::array<unsigned char, kTagSize> tag;
+    std::copy(sealed.end() - kTagSize, sealed.end(), tag.begin());
+    return crypt(false, chunkNonce(streamNonce, index), last ? 1 : 2, ciphertext,
+                 reinterpret_cast<unsigned char*>(output), tag.data());
+}
+
+// QueryRow accessors read straight from the stepped statement
+int QueryRow::columnCount() const {
+    return sqlite3_column_count(stmt_);
+}
+
+std::string_view QueryRow::columnName(int index) const {
+    const char* name = sqlite3_column_name(stmt_, index);
+    return name ? std::string_view(name) : std::string_view();
+}
+
+std::string_view QueryRow::column(int index) const {
+    const unsigned char* text = sqlite3_column_text(stmt_, index);
+    if (!text) {
+        return {};
+    }
+    return {reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_column_bytes(stmt_, index))};
+}
+
+std::int64_t QueryRow::columnInt(int index) const {
+    return sqlite3_column_int64(stmt_, index);
+}
+
+bool QueryRow::isNull(int index) const {
+    return sqlite3_column_type(stmt_, index) == SQLITE_NULL;
+}
+
 // Public interface implementation
-DataProcessor::DataProcessor() : pImpl(std::make_unique<Impl>()) {}
+DataProcessor::DataProcessor() : DataProcessor(DataProcessorOptions{}) {}
+
+DataProcessor::DataProcessor(const DataProcessorOptions& options)
+    : pImpl(std::make_unique<Impl>(options)) {}
 
 DataProcessor::~DataProcessor() = default;
 
-bool DataProcessor::processJsonData(const std::string& jsonData) {
+bool DataProcessor::processJsonData(std::string_view jsonData) {
     return pImpl->processJsonData(jsonData);
 }
 
+bool DataProcessor::processJsonLines(std::string_view data, const std::vector<std::string>& fields,
+                                     const JsonRecordVisitor& visitor) {
+    JsonStreamResult result;
+    return pImpl->processJsonLines(data, fields, visitor, result);
+}
+
+bool DataProcessor::processJsonLines(std::string_view data, const std::vector<std::string>& fields,
+                                     const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+    return pImpl->processJsonLines(data, fields, visitor, result);
+}
+
+bool DataProcessor::processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                                    const JsonRecordVisitor& visitor) {
+    JsonStreamResult result;
+    return pImpl->processJsonFile(path, fields, visitor, result, std::string());
+}
+
+bool DataProcessor::processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                                    const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+    return pImpl->processJsonFile(path, fields, visitor, result, std::string());
+}
+
+bool DataProcessor::processJsonFile(const std::string& path, const std::vector<std::string>& fields,
+                                    const JsonRecordVisitor& visitor, JsonStreamResult& result,
+                                    const std::string& encoding) {
+    return pImpl->processJsonFile(path, fields, visitor, result, encoding);
+}
+
+bool DataProcessor::processJsonBatch(std::string_view data, const std::vector<std::string>& fields,
+                                     const JsonRecordVisitor& visitor) {
+    JsonStreamResult result;
+    return pImpl->processJsonBatch(data, fields, visitor, result, "buffer");
+}
+
+bool DataProcessor::processJsonBatch(std::string_view data, const std::vector<std::string>& fields,
+                                     const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+    return pImpl->processJsonBatch(data, fields, visitor, result, "buffer");
+}
+
+bool DataProcessor::processJsonBatchFile(const std::string& path, const std::vector<std::string>& fields,
+                                         const JsonRecordVisitor& visitor) {
+    JsonStreamResult result;
+    return pImpl->processJsonBatchFile(path, fields, visitor, result);
+}
+
+bool DataProcessor::processJsonBatchFile(const std::string& path, const std::vector<std::string>& fields,
+                                         const JsonRecordVisitor& visitor, JsonStreamResult& result) {
+    return pImpl->processJsonBatchFile(path, fields, visitor, result);
+}
+
 std::string DataProcessor::generateJsonReport() const {
     return pImpl->generateJsonReport();
 }
 
 bool DataProcessor::processFilesInDirectory(const std::string& directoryPath) {
-    return pImpl->processFilesInDirectory(directoryPath);
+    return pImpl->processFilesInDirectory(directoryPath, FileVisitor());
+}
+
+bool DataProcessor::processFilesInDirectory(const std::string& directoryPath, const FileVisitor& visitor) {
+    return pImpl->processFilesInDirectory(directoryPath, visitor);
+}
+
+bool DataProcessor::indexDirectory(const std::string& directoryPath) {
+    IndexScanResult result;
+    return pImpl->indexDirectory(directoryPath, result);
+}
+
+bool DataProcessor::indexDirectory(const std::string& directoryPath, IndexScanResult& result) {
+    return pImpl->indexDirectory(directoryPath, result);
 }
 
 bool DataProcessor::compressFile(const std::string& inputPath, const std::string& outputPath) {
     return pImpl->compressFile(inputPath, outputPath);
 }
 
+bool DataProcessor::compressFile(const std::string& inputPath, const std::string& outputPath,
+                                 const CompressionOptions& options) {
+    return pImpl->compressFile(inputPath, outputPath, options);
+}
+
+bool DataProcessor::compressFile(const MappedBuffer& input, const std::string& outputPath,
+                                 const CompressionOptions& options) {
+    return pImpl->compressFile(input.view(), "mapped buffer", outputPath, options);
+}
+
 bool DataProcessor::decompressFile(const std::string& inputPath, const std::string& outputPath) {
-    // Implementation would be similar to compressFile but using inflate
-    return true;
+    return pImpl->decompressFile(inputPath, outputPath);
+}
+
+std::size_t DataProcessor::maxCompressedSize(std::size_t inputSize) const {
+    return ::compressBound(static_cast<uLong>(inputSize));
+}
+
+bool DataProcessor::compress(std::string_view input, char* output, std::size_t capacity,
+                             std::size_t& written, int level) {
+    return pImpl->compress(input, output, capacity, written, level);
+}
+
+bool DataProcessor::compress(std::string_view input, std::string& output, int level) {
+    return pImpl->compress(input, output, level);
+}
+
+bool DataProcessor::decompress(std::string_view input, char* output, std::size_t capacity, std::size_t& written) {
+    return pImpl->decompress(input, output, capacity, written);
+}
+
+bool DataProcessor::decompress(std::string_view input, std::string& output) {
+    return pImpl->decompress(input, output);
+}
+
+bool DataProcessor::decompressFile(const std::string& inputPath, const ChunkSink& sink) {
+    return pImpl->decompressFile(inputPath, sink);
+}
+
+bool DataProcessor::compressEncryptFile(const std::string& inputPath, const std::string& outputPath,
+                                        const CipherSession& session, const CompressionOptions& options) {
+    return pImpl->compressEncryptFile(inputPath, outputPath, session, options);
+}
+
+bool DataProcessor::decryptDecompressFile(const std::string& inputPath, const std::string& outputPath,
+                                          const CipherSession& session) {
+    return pImpl->decryptDecompressFile(inputPath, outputPath, session);
+}
+
+bool DataProcessor::decryptDecompressFile(const std::string& inputPath, const CipherSession& session,
+                                          const ChunkSink& sink) {
+    return pImpl->decryptDecompressFile(inputPath, session, sink);
+}
+
+BatchReport DataProcessor::runBatch(const BatchJob& job) {
+    return pImpl->runBatch(job);
 }
 
 bool DataProcessor::initializeDatabase(const std::string& dbPath) {
-    return pImpl->initializeDatabase(dbPath);
+    return pImpl->initializeDatabase(dbPath, DatabaseOptions{});
+}
+
+bool DataProcessor::initializeDatabase(const std::string& dbPath, const DatabaseOptions& options) {
+    return pImpl->initializeDatabase(dbPath, options);
 }
 
 bool DataProcessor::storeData(const std::string& table, const std::string& data) {
     return pImpl->storeData(table, data);
 }
 
+bool DataProcessor::storeBatch(const std::string& table, const std::vector<std::string>& rows) {
+    return pImpl->storeBatch(table, rows);
+}
+
+bool DataProcessor::flushWrites() {
+    return pImpl->flushWrites();
+}
+
 std::vector<std::string> DataProcessor::queryData(const std::string& query) {
-    // Implementation would query the database
-    return {};
+    std::vector<std::string> rows;
+    pImpl->queryData(query, {}, [&rows](const QueryRow& row) {
+        std::string line;
+        for (int i = 0; i < row.columnCount(); ++i) {
+            if (i > 0) {
+                line += '|';
+            }
+            line += row.column(i);
+        }
+        rows.push_back(std::move(line));
+        return true;
+    }, QueryOptions{});
+    return rows;
+}
+
+bool DataProcessor::queryData(const std::string& query, const std::vector<std::string>& params,
+                              const RowVisitor& visitor, const QueryOptions& options) {
+    return pImpl->queryData(query, params, visitor, options);
 }
 
 bool DataProcessor::downloadFile(const std::string& url, const std::string& localPath) {
     return pImpl->downloadFile(url, localPath);
 }
 
+bool DataProcessor::downloadFile(const std::string& url, const std::string& localPath,
+                                 const CipherSession& session, const CompressionOptions& options) {
+    return pImpl->downloadFile(url, localPath, session, options);
+}
+
+bool DataProcessor::downloadFile(const std::string& url, const ChunkSink& sink) {
+    return pImpl->downloadFile(url, sink);
+}
+
+bool DataProcessor::downloadFile(const std::string& url, const std::string& localPath, const DownloadOptions& options) {
+    return pImpl->downloadFile(url, localPath, options);
+}
+
+std::vector<HttpResponse> DataProcessor::downloadFiles(const std::vector<std::pair<std::string, std::string>>& transfers) {
+    return pImpl->downloadFiles(transfers);
+}
+
 std::string DataProcessor::makeHttpRequest(const std::string& url) {
-    // Implementation would make HTTP request
-    return "";
+    return pImpl->makeHttpRequest(url);
+}
+
+std::future<HttpResponse> DataProcessor::fetchAsync(const std::string& url) {
+    return pImpl->fetchAsync(url);
 }
 
 bool DataProcessor::processImage(const std::string& imagePath) {
-    // Implementation would process images using libpng/libjpeg-turbo
-    return true;
+    ImageInfo info;
+    return pImpl->processImage(imagePath, info);
+}
+
+bool DataProcessor::processImage(const std::string& imagePath, ImageInfo& info) {
+    return pImpl->processImage(imagePath, info);
 }
 
 bool DataProcessor::convertImageFormat(const std::string& inputPath, const std::string& outputPath) {
-    // Implementation would convert between image formats
-    return true;
+    return pImpl->convertImageFormat(inputPath, outputPath, ImageOptions{}).ok;
+}
+
+ImageResult DataProcessor::convertImageFormat(const std::string& inputPath, const std::string& outputPath,
+                                              const ImageOptions& options) {
+    return pImpl->convertImageFormat(inputPath, outputPath, options);
+}
+
+std::vector<ImageResult> DataProcessor::convertImages(const std::vector<std::pair<std::string, std::string>>& jobs,
+                                                      const ImageOptions& options) {
+    return pImpl->convertImages(jobs, options);
 }
 
-bool DataProcessor::processTextWithRegex(const std::string& text, const std::string& pattern) {
+bool DataProcessor::processTextWithRegex(std::string_view text, const std::string& pattern) {
     return pImpl->processTextWithRegex(text, pattern);
 }
 
-std::vector<std::string> DataProcessor::extractMatches(const std::string& text, const std::string& pattern) {
-    // Implementation would extract all matches
-    return {};
+bool DataProcessor::processTextWithRegex(std::string_view text, const std::string& pattern,
+                                         const std::string& encoding) {
+    return pImpl->processTextWithRegex(text, pattern, encoding);
+}
+
+bool DataProcessor::convertEncoding(std::string_view input, const std::string& fromEncoding,
+                                    const std::string& toEncoding, std::string& output) {
+    return pImpl->convertEncoding(input, fromEncoding, toEncoding, output);
+}
+
+bool DataProcessor::convertEncodingFile(const std::string& inputPath, const std::string& outputPath,
+                                        const std::string& fromEncoding, const std::string& toEncoding) {
+    return pImpl->convertEncodingFile(inputPath, outputPath, fromEncoding, toEncoding);
+}
+
+bool DataProcessor::convertEncodingFile(const std::string& inputPath, const std::string& fromEncoding,
+                                        const std::string& toEncoding, const ChunkSink& sink) {
+    return pImpl->convertEncodingFile(inputPath, fromEncoding, toEncoding, sink);
+}
+
+std::size_t DataProcessor::precompilePatterns(const std::vector<std::string>& patterns) {
+    return pImpl->precompilePatterns(patterns);
+}
+
+RegexCacheStats DataProcessor::regexCacheStats() const {
+    return pImpl->regexCacheStats();
+}
+
+std::vector<MatchSpan> DataProcessor::extractMatches(std::string_view text, const std::string& pattern) {
+    return pImpl->extractMatches(text, std::vector<std::string>{pattern});
+}
+
+std::vector<MatchSpan> DataProcessor::extractMatches(std::string_view text, const std::vector<std::string>& patterns) {
+    return pImpl->extractMatches(text, patterns);
+}
+
+std::vector<int> DataProcessor::scanWithPatternSet(std::string_view text, const std::vector<std::string>& patterns) {
+    return pImpl->scanWithPatternSet(text, patterns);
 }
 
 bool DataProcessor::renderText(const std::string& text, const std::string& fontPath, const std::string& outputPath) {
-    // Implementation would render text using FreeType/HarfBuzz
-    return true;
+    return pImpl->renderText(text, fontPath, outputPath, TextOptions{});
+}
+
+bool DataProcessor::renderText(const std::string& text, const std::string& fontPath, const std::string& outputPath,
+                               const TextOptions& options) {
+    return pImpl->renderText(text, fontPath, outputPath, options);
 }
 
 bool DataProcessor::processTextLayout(const std::string& text, const std::string& fontPath) {
-    // Implementation would process text layout
-    return true;
+    TextLayout layout;
+    return pImpl->processTextLayout(text, fontPath, TextOptions{}, layout);
+}
+
+bool DataProcessor::processTextLayout(const std::string& text, const std::string& fontPath,
+                                      const TextOptions& options, TextLayout& layout) {
+    return pImpl->processTextLayout(text, fontPath, options, layout);
+}
+
+TextCacheStats DataProcessor::textCacheStats() const {
+    return pImpl->textCacheStats();
 }
 
 std::string DataProcessor::encryptData(const std::string& data, const std::string& key) {
-    return pImpl->encryptData(data, key);
+    std::string result;
+    return pImpl->encryptData(data, key, result) ? result : std::string();
 }
 
 std::string DataProcessor::decryptData(const std::string& encryptedData, const std::string& key) {
-    // Implementation would decrypt data
-    return "";
+    std::string result;
+    return pImpl->decryptData(encryptedData, key, result) ? result : std::string();
 }
 
 std::string DataProcessor::generateHash(const std::string& data) {
     return pImpl->generateHash(data);
 }
 
-void DataProcessor::processDataAsync(const std::string& data, std::function<void(const std::string&)> callback) {
-    pImpl->processDataAsync(data, callback);
+bool DataProcessor::encryptData(std::string_view data, std::string_view key, std::string& output) {
+    return pImpl->encryptData(data, key, output);
+}
+
+bool DataProcessor::decryptData(std::string_view encryptedData, std::string_view key, std::string& output) {
+    return pImpl->decryptData(encryptedData, key, output);
+}
+
+bool DataProcessor::generateHash(std::string_view data, Sha256Hex& hex) {
+    return pImpl->generateHash(data, hex);
+}
+
+std::vector<Sha256Digest> DataProcessor::generateHashes(const std::vector<std::string>& inputs) {
+    return pImpl->generateHashes(inputs);
+}
+
+std::string DataProcessor::hashFile(const std::string& path) {
+    return pImpl->hashFile(path);
+}
+
+std::string DataProcessor::hashFile(const MappedBuffer& file) {
+    return pImpl->hashFile(file);
+}
+
+std::future<void> DataProcessor::processDataAsync(const std::string& data, std::function<void(const std::string&)> callback) {
+    return pImpl->processDataAsync(data, std::move(callback));
+}
+
+std::future<void> DataProcessor::processDataAsync(std::string&& data, std::function<void(const std::string&)> callback) {
+    return pImpl->processDataAsync(std::move(data), std::move(callback));
 }
 
 void DataProcessor::waitForCompletion() {
     pImpl->waitForCompletion();
 }
 
+bool DataProcessor::waitForCompletion(std::chrono::milliseconds timeout) {
+    return pImpl->waitForCompletion(timeout);
+}
+
+std::size_t DataProcessor::cancelPending() {
+    return pImpl->cancelPending();
+}
+
+std::size_t DataProcessor::pendingOperations() const {
+    return pImpl->pendingOperations();
+}
+
 void DataProcessor::setLogLevel(int level) {
     pImpl->setLogLevel(level);
 }
@@ -63,12 +63,12 @@ int main() {
         // Test compression
         logger->info("Testing compression...");
         std::string testData = "This is test data for compression. " + std::string(1000, 'A');
-        std::ofstream testFile("test_input.txt");
-        testFile << testData;
-        testFile.close();
+        std::string compressed;
+        std::string restored;
         
-        if (processor.compressFile("test_input.txt", "test_compressed.gz")) {
-            logger->info("Compression successful");
+        if (processor.compress(testData, compressed) && processor.decompress(compressed, restored) &&
+            restored == testData) {
+            logger->info("Compression successful: {} -> {} bytes", testData.size(), compressed.size());
         } else {
             logger->error("Compression failed");
         }
@@ -162,8 +162,6 @@ int main() {
         logger->info("===================");
         
         // Cleanup
-        std::remove("test_input.txt");
-        std::remove("test_compressed.gz");
         std::remove("test.db");
         
         logger->info("Demo completed successfully!");
@@ -4,9 +4,35 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 #include <fmt/format.h>
+#include <nlohmann/json.hpp>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <thread>
+
+// Counts allocations made by the calling thread, for the steady-state tests
+static thread_local std::size_t threadAllocations = 0;
+
+void* operator new(std::size_t size) {
+    ++threadAllocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
 
 // Catch2 Tests
 TEST_CASE("DataProcessor JSON Processing", "[json]") {
@@ -22,6 +48,71 @@ TEST_CASE("DataProcessor JSON Processing", "[json]") {
         REQUIRE(processor.processJsonData(invalidJson) == false);
     }
     
+    SECTION("NDJSON field selection") {
+        std::string ndjson = "{\"id\": 1, \"user\": {\"name\": \"ada\", \"langs\": [\"c\"]}}\n"
+                             "\n"
+                             "{\"id\": 2, \"user\": {\"name\": \"bob\"}}\r\n"
+                             "{\"id\": 3}";
+        std::vector<std::string> names;
+        std::int64_t idSum = 0;
+        std::size_t containers = 0;
+        JsonStreamResult result;
+        REQUIRE(processor.processJsonLines(ndjson, {"id", "user.name", "user.langs"},
+            [&](std::size_t, const std::vector<JsonField>& fields) {
+                idSum += fields[0].integer;
+                if (fields[1].type == JsonType::String) {
+                    names.push_back(fields[1].text);
+                }
+                containers += fields[2].type == JsonType::Container ? 1 : 0;
+                return true;
+            }, result) == true);
+        REQUIRE(result.records == 3);
+        REQUIRE(idSum == 6);
+        REQUIRE(names == std::vector<std::string>{"ada", "bob"});
+        REQUIRE(containers == 1);
+    }
+    
+    SECTION("Parallel NDJSON batch") {
+        std::string ndjson;
+        for (int i = 1; i <= 50000; ++i) {
+            ndjson += "{\"n\": " + std::to_string(i) + ", \"tag\": \"batch record payload\"}\n";
+        }
+        std::atomic<std::int64_t> sum{0};
+        std::atomic<bool> linesMatch{true};
+        JsonStreamResult result;
+        REQUIRE(processor.processJsonBatch(ndjson, {"n"},
+            [&](std::size_t line, const std::vector<JsonField>& fields) {
+                sum += fields[0].integer;
+                if (static_cast<std::int64_t>(line) != fields[0].integer) {
+                    linesMatch = false;
+                }
+                return true;
+            }, result) == true);
+        REQUIRE(result.records == 50000);
+        REQUIRE(sum == std::int64_t(50000) * 50001 / 2);
+        REQUIRE(linesMatch);
+        REQUIRE(processor.generateJsonReport().find("\"processed_items\": 50000") != std::string::npos);
+    }
+    
+    SECTION("Operation statistics in report") {
+        for (int i = 0; i < 100; ++i) {
+            processor.processJsonData(R"({"i": 1})");
+            processor.generateHash("stats input " + std::to_string(i));
+        }
+        processor.processJsonData("{");
+        
+        auto report = nlohmann::json::parse(processor.generateJsonReport());
+        REQUIRE(report["stats_enabled"] == true);
+        REQUIRE(report["processed_items"] == 200);
+        REQUIRE(report["errors"] == 1);
+        REQUIRE(report["operations"]["json"]["calls"] == 101);
+        REQUIRE(report["operations"]["hash"]["items"] == 100);
+        const auto& latency = report["operations"]["hash"]["latency_us"];
+        REQUIRE(latency["p50"].get<double>() > 0.0);
+        REQUIRE(latency["p50"].get<double>() <= latency["p99"].get<double>());
+        REQUIRE(latency["p99"].get<double>() <= latency["p999"].get<double>());
+    }
+    
     SECTION("JSON report generation") {
         std::string report = processor.generateJsonReport();
         REQUIRE(!report.empty());
@@ -37,6 +128,30 @@ TEST_CASE("DataProcessor File Operations", "[filesystem]") {
         REQUIRE(processor.processFilesInDirectory(".") == true);
     }
     
+    SECTION("Parallel directory scan") {
+        for (int dir = 0; dir < 3; ++dir) {
+            std::string subdir = "test_scan_dir/sub" + std::to_string(dir) + "/nested";
+            std::filesystem::create_directories(subdir);
+            for (int file = 0; file < 4; ++file) {
+                std::ofstream(subdir + "/file" + std::to_string(file) + ".txt") << "scan data";
+            }
+        }
+        for (int file = 0; file < 4; ++file) {
+            std::ofstream("test_scan_dir/top" + std::to_string(file) + ".txt") << "scan data";
+        }
+        
+        std::atomic<int> visited{0};
+        REQUIRE(processor.processFilesInDirectory("test_scan_dir", [&visited](const std::string&) {
+            visited++;
+        }) == true);
+        REQUIRE(visited == 3 * 4 + 4);
+        
+        REQUIRE(processor.processFilesInDirectory("test_scan_dir_missing") == false);
+        
+        // Cleanup
+        std::filesystem::remove_all("test_scan_dir");
+    }
+    
     SECTION("Compression") {
         // Create test file
         std::ofstream testFile("test_compress.txt");
@@ -49,6 +164,103 @@ TEST_CASE("DataProcessor File Operations", "[filesystem]") {
         std::remove("test_compress.txt");
         std::remove("test_compressed.gz");
     }
+    
+    SECTION("Parallel gzip compression") {
+        std::ofstream testFile("test_parallel.txt", std::ios::binary);
+        for (int i = 0; i < 20000; ++i) {
+            testFile << "line " << i << " of parallel compression input\n";
+        }
+        testFile.close();
+        
+        CompressionOptions options;
+        options.level = 9;
+        options.blockSize = 64 * 1024;
+        REQUIRE(processor.compressFile("test_parallel.txt", "test_parallel.gz", options) == true);
+        
+        std::ifstream compressed("test_parallel.gz", std::ios::binary);
+        unsigned char magic[2] = {0, 0};
+        compressed.read(reinterpret_cast<char*>(magic), 2);
+        REQUIRE(magic[0] == 0x1f);
+        REQUIRE(magic[1] == 0x8b);
+        compressed.close();
+        
+        REQUIRE(processor.decompressFile("test_parallel.gz", "test_parallel.out") == true);
+        std::ifstream original("test_parallel.txt", std::ios::binary);
+        std::ifstream restored("test_parallel.out", std::ios::binary);
+        std::stringstream originalData, restoredData;
+        originalData << original.rdbuf();
+        restoredData << restored.rdbuf();
+        REQUIRE(originalData.str() == restoredData.str());
+        original.close();
+        restored.close();
+        
+        // Cleanup
+        std::remove("test_parallel.txt");
+        std::remove("test_parallel.gz");
+        std::remove("test_parallel.out");
+    }
+    
+    SECTION("In-memory compression") {
+        std::string data = "In-memory compression round trip " + std::string(4096, 'M');
+        std::string compressed;
+        std::string restored;
+        
+        REQUIRE(processor.compress(data, compressed) == true);
+        REQUIRE(compressed.size() < data.size());
+        REQUIRE(processor.decompress(compressed, restored) == true);
+        REQUIRE(restored == data);
+        
+        std::vector<char> buffer(processor.maxCompressedSize(data.size()));
+        std::size_t written = 0;
+        REQUIRE(processor.compress(data, buffer.data(), buffer.size(), written, 9) == true);
+        REQUIRE(written > 0);
+        
+        char tooSmall[8];
+        REQUIRE(processor.decompress(std::string_view(buffer.data(), written), tooSmall, sizeof(tooSmall), written) == false);
+    }
+    
+    SECTION("Sealed archive round trip") {
+        std::ofstream testFile("test_sealed.txt", std::ios::binary);
+        for (int i = 0; i < 20000; ++i) {
+            testFile << "line " << i << " of sealed archive input\n";
+        }
+        testFile.close();
+        
+        CipherSession session(std::string(CipherSession::kKeySize, 's'));
+        CompressionOptions options;
+        options.blockSize = 64 * 1024;
+        REQUIRE(processor.compressEncryptFile("test_sealed.txt", "test_sealed.dpsa", session, options) == true);
+        REQUIRE(processor.decryptDecompressFile("test_sealed.dpsa", "test_sealed.out", session) == true);
+        
+        std::ifstream original("test_sealed.txt", std::ios::binary);
+        std::ifstream restored("test_sealed.out", std::ios::binary);
+        std::stringstream originalData, restoredData;
+        originalData << original.rdbuf();
+        restoredData << restored.rdbuf();
+        REQUIRE(originalData.str() == restoredData.str());
+        original.close();
+        restored.close();
+        
+        CipherSession wrongKey(std::string(CipherSession::kKeySize, 'w'));
+        REQUIRE(processor.decryptDecompressFile("test_sealed.dpsa", "test_sealed.out", wrongKey) == false);
+        
+        // Cleanup
+        std::remove("test_sealed.txt");
+        std::remove("test_sealed.dpsa");
+        std::remove("test_sealed.out");
+    }
+    
+    SECTION("Decompression rejects unknown formats") {
+        std::ofstream testFile("test_plain.txt");
+        testFile << "Not compressed at all";
+        testFile.close();
+        
+        REQUIRE(processor.decompressFile("test_plain.txt", "test_plain.out") == false);
+        
+        // Cleanup
+        std::remove("test_plain.txt");
+        std::remove("test_plain.out");
+    }
 }
 
 TEST_CASE("DataProcessor Database Operations", "[database]") {
@@ -61,11 +273,77 @@ TEST_CASE("DataProcessor Database Operations", "[database]") {
             REQUIRE(processor.storeData("data_processor_logs", "Test data") == true);
         }
         
+        SECTION("Batch storage") {
+            std::vector<std::string> rows(100, "Batch row");
+            REQUIRE(processor.storeBatch("data_processor_logs", rows) == true);
+            REQUIRE(processor.storeBatch("missing_table", rows) == false);
+        }
+        
+        SECTION("Streaming query") {
+            std::vector<std::string> rows = {"alpha", "beta", "gamma"};
+            REQUIRE(processor.storeBatch("data_processor_logs", rows) == true);
+            
+            std::vector<std::string> seen;
+            QueryOptions options;
+            options.pageSize = 1;
+            bool ok = processor.queryData("SELECT details FROM data_processor_logs WHERE details != ?1 ORDER BY id",
+                                          {"beta"}, [&seen](const QueryRow& row) {
+                seen.emplace_back(row.column(0));
+                return true;
+            }, options);
+            
+            REQUIRE(ok == true);
+            REQUIRE(seen == std::vector<std::string>{"alpha", "gamma"});
+        }
+        
+        SECTION("File index requires the table") {
+            REQUIRE(processor.indexDirectory(".") == false);
+        }
+        
         // Cleanup
         std::remove("test_db.db");
     }
 }
 
+TEST_CASE("DataProcessor Network Operations", "[network]") {
+    DataProcessor processor;
+    
+    // file:// URLs exercise the transfer machinery without a server
+    std::ofstream testFile("test_fetch.txt", std::ios::binary);
+    testFile << "Fetched through the HTTP client";
+    testFile.close();
+    const std::string url = "file://" + std::filesystem::absolute("test_fetch.txt").string();
+    
+    SECTION("Async fetch") {
+        HttpResponse response = processor.fetchAsync(url).get();
+        REQUIRE(response.ok);
+        REQUIRE(response.body == "Fetched through the HTTP client");
+        REQUIRE(processor.makeHttpRequest(url) == response.body);
+    }
+    
+    SECTION("Failed fetch") {
+        HttpResponse response = processor.fetchAsync(url + ".missing").get();
+        REQUIRE_FALSE(response.ok);
+        REQUIRE_FALSE(response.error.empty());
+        REQUIRE(processor.makeHttpRequest(url + ".missing").empty());
+    }
+    
+    SECTION("Streaming download into a sink") {
+        Hasher hasher;
+        REQUIRE(processor.downloadFile(url, [&hasher](std::string_view chunk) { return hasher.update(chunk); }));
+        Sha256Digest digest;
+        REQUIRE(hasher.finalize(digest));
+        Sha256Hex hex = Hasher::toHex(digest);
+        REQUIRE(std::string(hex.data(), hex.size()) == processor.generateHash("Fetched through the HTTP client"));
+        
+        // A sink returning false aborts the transfer
+        REQUIRE(processor.downloadFile(url, [](std::string_view) { return false; }) == false);
+    }
+    
+    // Cleanup
+    std::remove("test_fetch.txt");
+}
+
 TEST_CASE("DataProcessor Text Processing", "[text]") {
     DataProcessor processor;
     
@@ -82,6 +360,30 @@ TEST_CASE("DataProcessor Text Processing", "[text]") {
         
         REQUIRE(processor.processTextWithRegex(text, invalidPattern) == false);
     }
+    
+    SECTION("Regex cache") {
+        std::string digits = R"(\d+)";
+        REQUIRE(processor.precompilePatterns({digits, R"([invalid)"}) == 1);
+        
+        RegexCacheStats before = processor.regexCacheStats();
+        REQUIRE(processor.processTextWithRegex("order 42", digits) == true);
+        RegexCacheStats after = processor.regexCacheStats();
+        
+        REQUIRE(after.hits == before.hits + 1);
+        REQUIRE(after.misses == before.misses);
+    }
+    
+    SECTION("Pattern set scan") {
+        std::string text = "Contact: test@example.com or 123-456-7890";
+        std::vector<std::string> patterns = {
+            R"([a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,})",
+            R"(ID-\d+)",
+            R"(\d{3}-\d{3}-\d{4})"
+        };
+        
+        REQUIRE(processor.scanWithPatternSet(text, patterns) == std::vector<int>{0, 2});
+        REQUIRE(processor.scanWithPatternSet(text, {R"([invalid)"}).empty());
+    }
 }
 
 TEST_CASE("DataProcessor Cryptography", "[crypto]") {
@@ -96,6 +398,31 @@ TEST_CASE("DataProcessor Cryptography", "[crypto]") {
         REQUIRE(encrypted != plaintext);
     }
     
+    SECTION("Data decryption") {
+        std::string plaintext = "Secret message";
+        std::string key = "mysecretkey1234567890123456789012"; // 32 bytes
+        
+        std::string encrypted = processor.encryptData(plaintext, key);
+        REQUIRE(processor.decryptData(encrypted, key) == plaintext);
+        REQUIRE(processor.decryptData(encrypted, "a different key, also 32+ bytes!!").empty());
+    }
+    
+    SECTION("AES-GCM session") {
+        CipherSession session(std::string(CipherSession::kKeySize, 'k'));
+        REQUIRE(session.ok());
+        REQUIRE_FALSE(CipherSession("too short").ok());
+        
+        std::string plaintext = "Authenticated secret";
+        std::vector<char> sealed(CipherSession::sealedSize(plaintext.size()));
+        std::size_t written = 0;
+        REQUIRE(session.seal(plaintext, sealed.data(), sealed.size(), written));
+        REQUIRE(written == sealed.size());
+        
+        std::vector<char> opened(plaintext.size());
+        REQUIRE(session.open(std::string_view(sealed.data(), written), opened.data(), opened.size(), written));
+        REQUIRE(std::string(opened.data(), written) == plaintext);
+    }
+    
     SECTION("Hash generation") {
         std::string data = "Test data for hashing";
         std::string hash = processor.generateHash(data);
@@ -111,6 +438,22 @@ TEST_CASE("DataProcessor Cryptography", "[crypto]") {
         
         REQUIRE(hash1 == hash2);
     }
+    
+    SECTION("Incremental hashing") {
+        Hasher hasher;
+        REQUIRE(hasher.update("Incremental "));
+        REQUIRE(hasher.update("hash test"));
+        
+        Sha256Digest digest;
+        REQUIRE(hasher.finalize(digest));
+        Sha256Hex hex = Hasher::toHex(digest);
+        REQUIRE(std::string(hex.data(), hex.size()) == processor.generateHash("Incremental hash test"));
+        
+        auto digests = processor.generateHashes({"Incremental hash test", "other"});
+        REQUIRE(digests.size() == 2);
+        REQUIRE(digests[0] == digest);
+        REQUIRE(digests[1] != digest);
+    }
 }
 
 TEST_CASE("DataProcessor Async Operations", "[async]") {
@@ -130,6 +473,54 @@ TEST_CASE("DataProcessor Async Operations", "[async]") {
         REQUIRE(callbackCalled == true);
         REQUIRE(!result.empty());
     }
+    
+    SECTION("Bounded worker pool") {
+        DataProcessorOptions options;
+        options.workerThreads = 2;
+        options.maxQueuedTasks = 4;
+        DataProcessor pooled(options);
+        
+        std::atomic<int> completed{0};
+        for (int i = 0; i < 64; ++i) {
+            pooled.processDataAsync("item " + std::to_string(i), [&completed](const std::string&) {
+                completed++;
+            });
+        }
+        
+        pooled.waitForCompletion();
+        REQUIRE(completed == 64);
+    }
+    
+    SECTION("Timed wait and cancellation") {
+        REQUIRE(processor.waitForCompletion(std::chrono::milliseconds(0)) == true);
+        
+        DataProcessorOptions options;
+        options.workerThreads = 1;
+        DataProcessor single(options);
+        
+        std::atomic<int> completed{0};
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 32; ++i) {
+            futures.push_back(single.processDataAsync(std::string(10000, 'x'), [&completed](const std::string&) {
+                completed++;
+            }));
+        }
+        
+        std::size_t cancelled = single.cancelPending();
+        REQUIRE(single.waitForCompletion(std::chrono::seconds(5)) == true);
+        REQUIRE(single.pendingOperations() == 0);
+        REQUIRE(static_cast<std::size_t>(completed) + cancelled == futures.size());
+        
+        std::size_t broken = 0;
+        for (auto& future : futures) {
+            try {
+                future.get();
+            } catch (const std::future_error&) {
+                broken++;
+            }
+        }
+        REQUIRE(broken == cancelled);
+    }
 }
 
 TEST_CASE("DataProcessor Error Handling", "[errors]") {
@@ -190,10 +581,189 @@ TEST_F(DataProcessorTest, JsonReportGeneration) {
     EXPECT_NE(report.find("status"), std::string::npos);
 }
 
+TEST_F(DataProcessorTest, JsonFileStreamingSkipsMalformedLines) {
+    std::ofstream testFile("gtest_records.ndjson", std::ios::binary);
+    for (int i = 0; i < 1000; ++i) {
+        testFile << "{\"seq\": " << i << ", \"payload\": \"" << std::string(100, 'p') << "\"}\n";
+        if (i == 500) {
+            testFile << "{\"seq\": broken\n";
+        }
+    }
+    testFile.close();
+    
+    std::size_t lastLine = 0;
+    std::int64_t lastSeq = -1;
+    JsonStreamResult result;
+    EXPECT_FALSE(processor_->processJsonFile("gtest_records.ndjson", {"seq"},
+        [&](std::size_t line, const std::vector<JsonField>& fields) {
+            lastLine = line;
+            lastSeq = fields[0].integer;
+            return true;
+        }, result));
+    EXPECT_EQ(result.records, 1000u);
+    EXPECT_EQ(result.errors, 1u);
+    EXPECT_EQ(lastSeq, 999);
+    EXPECT_EQ(lastLine, 1001u);
+    
+    // Stopping early is not an error
+    std::size_t seen = 0;
+    EXPECT_TRUE(processor_->processJsonFile("gtest_records.ndjson", {"seq"},
+        [&seen](std::size_t, const std::vector<JsonField>&) { return ++seen < 10; }));
+    EXPECT_EQ(seen, 10u);
+    
+    // Cleanup
+    std::remove("gtest_records.ndjson");
+}
+
+TEST_F(DataProcessorTest, JsonBatchFileCountsErrors) {
+    std::ofstream testFile("gtest_batch.ndjson", std::ios::binary);
+    for (int i = 0; i < 100000; ++i) {
+        testFile << "{\"id\": " << i << ", \"name\": \"record " << i << "\"}\n";
+        if (i % 25000 == 0) {
+            testFile << "{\"id\": \n";
+        }
+    }
+    testFile.close();
+    
+    std::atomic<std::size_t> named{0};
+    JsonStreamResult result;
+    EXPECT_FALSE(processor_->processJsonBatchFile("gtest_batch.ndjson", {"name"},
+        [&named](std::size_t, const std::vector<JsonField>& fields) {
+            named += fields[0].type == JsonType::String ? 1 : 0;
+            return true;
+        }, result));
+    EXPECT_EQ(result.records, 100000u);
+    EXPECT_EQ(result.errors, 4u);
+    EXPECT_EQ(named.load(), 100000u);
+    
+    std::string report = processor_->generateJsonReport();
+    EXPECT_NE(report.find("\"errors\": 4"), std::string::npos);
+    
+    // Cleanup
+    std::remove("gtest_batch.ndjson");
+}
+
+TEST_F(DataProcessorTest, SharedInstanceIsSafeAcrossThreads) {
+    const std::string expectedHash = processor_->generateHash("shared");
+    std::string packedReference;
+    ASSERT_TRUE(processor_->compress(std::string(10000, 's'), packedReference));
+    
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string packed;
+            std::string unpacked;
+            for (int i = 0; i < 200; ++i) {
+                const std::string text = fmt::format("thread {} item {}", t, i);
+                if (processor_->generateHash("shared") != expectedHash ||
+                    !processor_->processTextWithRegex(text, R"(item \d+)") ||
+                    !processor_->compress(text, packed) || !processor_->decompress(packed, unpacked) ||
+                    unpacked != text || !processor_->processJsonData(R"({"t": 1})")) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_FALSE(processor_->hasErrors());
+    // One miss to compile the pattern; every other lookup is a hit
+    RegexCacheStats stats = processor_->regexCacheStats();
+    EXPECT_GE(stats.hits, 8u * 200u - 8u);
+}
+
+TEST_F(DataProcessorTest, ProcessorsCoexistAndHonourFeatureMask) {
+    DataProcessorOptions options;
+    options.features = Feature::None;
+    DataProcessor minimal(options);
+    DataProcessor full;
+    
+    // Both processors got working loggers and independent state
+    EXPECT_EQ(minimal.generateHash("coexist"), processor_->generateHash("coexist"));
+    EXPECT_FALSE(minimal.hasErrors());
+    
+    EXPECT_FALSE(minimal.downloadFile("file:///dev/null", "test_feature_mask.txt"));
+    EXPECT_FALSE(minimal.processTextLayout("text", "font.ttf"));
+    
+    // The same transfer goes through on the processor with every feature
+    std::ofstream("test_feature_mask_src.txt") << "feature mask payload";
+    const std::string url = "file://" + std::filesystem::absolute("test_feature_mask_src.txt").string();
+    EXPECT_TRUE(full.downloadFile(url, "test_feature_mask.txt"));
+    std::ifstream downloaded("test_feature_mask.txt");
+    std::stringstream content;
+    content << downloaded.rdbuf();
+    EXPECT_EQ(content.str(), "feature mask payload");
+    EXPECT_FALSE(full.hasErrors());
+    
+    for (int i = 0; i < 100; ++i) {
+        DataProcessor shortLived(options);
+        ASSERT_TRUE(shortLived.processJsonData(R"({"short": "lived"})"));
+    }
+    std::filesystem::remove("test_feature_mask.txt");
+    std::filesystem::remove("test_feature_mask_src.txt");
+}
+
+TEST_F(DataProcessorTest, AsyncLoggingBlocksInsteadOfDroppingWhenFull) {
+    DataProcessorOptions options;
+    options.logging.queueSize = 2;
+    options.logging.dropOnOverflow = false;
+    DataProcessor processor(options);
+    
+    // A two-record ring of its own, so the flood has to wait for the log thread
+    for (int i = 0; i < 1000; ++i) {
+        processor.logOperation("flood", std::to_string(i));
+    }
+    EXPECT_EQ(processor.generateHash("after flood").size(), 64u);
+    
+    auto report = nlohmann::json::parse(processor.generateJsonReport());
+    EXPECT_EQ(report["logging"]["queue_size"], 2);
+    EXPECT_EQ(report["logging"]["overruns"], 0);
+    EXPECT_FALSE(processor.hasErrors());
+}
+
+TEST_F(DataProcessorTest, StatisticsCanBeDisabled) {
+    DataProcessorOptions options;
+    options.collectStats = false;
+    DataProcessor processor(options);
+    
+    processor.processJsonData(R"({"untracked": true})");
+    processor.generateHash("untracked");
+    processor.processJsonData("{");
+    
+    // The histograms are gone but the totals still count
+    auto report = nlohmann::json::parse(processor.generateJsonReport());
+    EXPECT_EQ(report["stats_enabled"], false);
+    EXPECT_FALSE(report.contains("operations"));
+    EXPECT_EQ(report["processed_items"], 2);
+    EXPECT_EQ(report["errors"], 1);
+}
+
 TEST_F(DataProcessorTest, FileSystemOperations) {
     EXPECT_TRUE(processor_->processFilesInDirectory("."));
 }
 
+TEST_F(DataProcessorTest, DirectoryScanReportsVisitorFailures) {
+    std::filesystem::create_directories("gtest_scan_dir/inner");
+    std::ofstream("gtest_scan_dir/inner/bad.txt") << "bad";
+    std::ofstream("gtest_scan_dir/good.txt") << "good";
+    
+    std::atomic<int> visited{0};
+    EXPECT_FALSE(processor_->processFilesInDirectory("gtest_scan_dir", [&visited](const std::string& path) {
+        visited++;
+        if (path.find("bad.txt") != std::string::npos) {
+            throw std::runtime_error("cannot process");
+        }
+    }));
+    EXPECT_EQ(visited, 2);
+    
+    // Cleanup
+    std::filesystem::remove_all("gtest_scan_dir");
+}
+
 TEST_F(DataProcessorTest, CompressionWorks) {
     // Create test file
     std::ofstream testFile("gtest_compress.txt");
@@ -202,11 +772,101 @@ TEST_F(DataProcessorTest, CompressionWorks) {
     
     EXPECT_TRUE(processor_->compressFile("gtest_compress.txt", "gtest_compressed.gz"));
     
+    // A directory opens but can't be read; no partial archive is left behind
+    std::filesystem::create_directories("gtest_compress_dir");
+    EXPECT_FALSE(processor_->compressFile("gtest_compress_dir", "gtest_compress_dir.gz"));
+    EXPECT_FALSE(std::filesystem::exists("gtest_compress_dir.gz"));
+    EXPECT_FALSE(processor_->compressFile("gtest_compress_dir", "gtest_compress_dir.gz", CompressionOptions{}));
+    EXPECT_FALSE(std::filesystem::exists("gtest_compress_dir.gz"));
+    std::filesystem::remove("gtest_compress_dir");
+    
     // Cleanup
     std::remove("gtest_compress.txt");
     std::remove("gtest_compressed.gz");
 }
 
+TEST_F(DataProcessorTest, DecompressionStreamsToSink) {
+    std::string data = "Test data for streaming decompression. " + std::string(5000, 'Z');
+    std::ofstream testFile("gtest_decompress.txt", std::ios::binary);
+    testFile << data;
+    testFile.close();
+    
+    // The two-argument compressFile writes a zlib stream
+    ASSERT_TRUE(processor_->compressFile("gtest_decompress.txt", "gtest_decompress.z"));
+    
+    std::string restored;
+    EXPECT_TRUE(processor_->decompressFile("gtest_decompress.z", [&restored](std::string_view chunk) {
+        restored.append(chunk.data(), chunk.size());
+        return true;
+    }));
+    EXPECT_EQ(restored, data);
+    
+    // Cleanup
+    std::remove("gtest_decompress.txt");
+    std::remove("gtest_decompress.z");
+}
+
+TEST_F(DataProcessorTest, SealedArchiveRejectsTruncation) {
+    std::string data;
+    for (int i = 0; i < 5000; ++i) {
+        data += "sealed record " + std::to_string(i) + "\n";
+    }
+    std::ofstream testFile("gtest_sealed.txt", std::ios::binary);
+    testFile << data;
+    testFile.close();
+    
+    CipherSession session(std::string(CipherSession::kKeySize, 'g'));
+    CompressionOptions options;
+    options.blockSize = 32 * 1024;
+    options.parallel = false;
+    ASSERT_TRUE(processor_->compressEncryptFile("gtest_sealed.txt", "gtest_sealed.dpsa", session, options));
+    
+    std::string restored;
+    EXPECT_TRUE(processor_->decryptDecompressFile("gtest_sealed.dpsa", session, [&restored](std::string_view chunk) {
+        restored.append(chunk.data(), chunk.size());
+        return true;
+    }));
+    EXPECT_EQ(restored, data);
+    
+    // A sealed download drains the transfer's chunks on the calling thread
+    const std::string url = "file://" + std::filesystem::absolute("gtest_sealed.txt").string();
+    ASSERT_TRUE(processor_->downloadFile(url, "gtest_sealed_download.dpsa", session, options));
+    restored.clear();
+    EXPECT_TRUE(processor_->decryptDecompressFile("gtest_sealed_download.dpsa", session, [&restored](std::string_view chunk) {
+        restored.append(chunk.data(), chunk.size());
+        return true;
+    }));
+    EXPECT_EQ(restored, data);
+    EXPECT_FALSE(processor_->downloadFile(url + ".missing", "gtest_sealed_download.dpsa", session, options));
+    
+    // Dropping the tail must fail authentication rather than yield a short file
+    std::ifstream sealedFile("gtest_sealed.dpsa", std::ios::binary);
+    std::stringstream sealed;
+    sealed << sealedFile.rdbuf();
+    sealedFile.close();
+    std::ofstream truncated("gtest_sealed_short.dpsa", std::ios::binary);
+    truncated << sealed.str().substr(0, sealed.str().size() - 8);
+    truncated.close();
+    EXPECT_FALSE(processor_->decryptDecompressFile("gtest_sealed_short.dpsa", "gtest_sealed.out", session));
+    
+    // Cleanup
+    std::remove("gtest_sealed.txt");
+    std::remove("gtest_sealed.dpsa");
+    std::remove("gtest_sealed_short.dpsa");
+    std::remove("gtest_sealed_download.dpsa");
+    std::remove("gtest_sealed.out");
+}
+
+TEST_F(DataProcessorTest, InMemoryDecompressionRejectsGarbage) {
+    std::string restored;
+    EXPECT_FALSE(processor_->decompress("definitely not zlib", restored));
+    
+    std::string compressed;
+    EXPECT_TRUE(processor_->compress("", compressed));
+    EXPECT_TRUE(processor_->decompress(compressed, restored));
+    EXPECT_TRUE(restored.empty());
+}
+
 TEST_F(DataProcessorTest, DatabaseOperations) {
     EXPECT_TRUE(processor_->initializeDatabase("gtest_db.db"));
     EXPECT_TRUE(processor_->storeData("data_processor_logs", "GTest data"));
@@ -215,6 +875,324 @@ TEST_F(DataProcessorTest, DatabaseOperations) {
     std::remove("gtest_db.db");
 }
 
+TEST_F(DataProcessorTest, QueryDataReturnsStoredRows) {
+    EXPECT_TRUE(processor_->initializeDatabase("gtest_query_db.db"));
+    EXPECT_TRUE(processor_->storeData("data_processor_logs", "Queried row"));
+    
+    auto rows = processor_->queryData("SELECT operation, details FROM data_processor_logs");
+    ASSERT_EQ(rows.size(), 1);
+    EXPECT_EQ(rows[0], "data_storage|Queried row");
+    
+    int visited = 0;
+    EXPECT_TRUE(processor_->queryData("SELECT id FROM data_processor_logs", {}, [&visited](const QueryRow&) {
+        visited++;
+        return false;
+    }));
+    EXPECT_EQ(visited, 1);
+    
+    // Cleanup
+    processor_.reset();
+    std::remove("gtest_query_db.db");
+}
+
+TEST_F(DataProcessorTest, IncrementalFileIndex) {
+    DatabaseOptions options;
+    options.fileIndex = true;
+    ASSERT_TRUE(processor_->initializeDatabase("gtest_index_db.db", options));
+    
+    std::filesystem::create_directories("gtest_index_dir/sub");
+    std::ofstream("gtest_index_dir/a.txt") << "first";
+    std::ofstream("gtest_index_dir/sub/b.txt") << "second";
+    
+    IndexScanResult result;
+    EXPECT_TRUE(processor_->indexDirectory("gtest_index_dir", result));
+    EXPECT_EQ(result.added, 2);
+    
+    EXPECT_TRUE(processor_->indexDirectory("gtest_index_dir", result));
+    EXPECT_EQ(result.unchanged, 2);
+    EXPECT_EQ(result.added + result.changed + result.removed, 0);
+    
+    std::filesystem::remove("gtest_index_dir/sub/b.txt");
+    std::ofstream("gtest_index_dir/a.txt") << "first, now longer";
+    EXPECT_TRUE(processor_->indexDirectory("gtest_index_dir", result));
+    EXPECT_EQ(result.changed, 1);
+    EXPECT_EQ(result.removed, 1);
+    
+    // Same size, rewritten a millisecond later: still a change
+    const auto indexedTime = std::filesystem::last_write_time("gtest_index_dir/a.txt");
+    std::ofstream("gtest_index_dir/a.txt") << "first, now LONGER";
+    std::filesystem::last_write_time("gtest_index_dir/a.txt", indexedTime + std::chrono::milliseconds(1));
+    EXPECT_TRUE(processor_->indexDirectory("gtest_index_dir", result));
+    EXPECT_EQ(result.changed, 1);
+    
+    // Cleanup
+    processor_.reset();
+    std::filesystem::remove_all("gtest_index_dir");
+    std::remove("gtest_index_db.db");
+}
+
+TEST_F(DataProcessorTest, BackgroundWriterDatabaseOperations) {
+    DatabaseOptions options;
+    options.walMode = true;
+    options.synchronousNormal = true;
+    options.backgroundWriter = true;
+    options.writerBatchSize = 64;
+    options.writerQueueLimit = 16;
+    
+    EXPECT_TRUE(processor_->initializeDatabase("gtest_writer_db.db", options));
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_TRUE(processor_->storeData("data_processor_logs", "Queued row " + std::to_string(i)));
+    }
+    EXPECT_TRUE(processor_->flushWrites());
+    EXPECT_EQ(processor_->queryData("SELECT COUNT(*) FROM data_processor_logs"), std::vector<std::string>{"500"});
+    EXPECT_FALSE(processor_->hasErrors());
+    
+    // A row the writer can't insert is accepted by storeData but reported by the flush
+    EXPECT_TRUE(processor_->storeData("missing_table", "lost row"));
+    EXPECT_FALSE(processor_->flushWrites());
+    EXPECT_TRUE(processor_->hasErrors());
+    EXPECT_TRUE(processor_->flushWrites());
+    
+    // Cleanup
+    processor_.reset();
+    std::remove("gtest_writer_db.db");
+    std::remove("gtest_writer_db.db-wal");
+    std::remove("gtest_writer_db.db-shm");
+}
+
+TEST_F(DataProcessorTest, ReadConnectionsQueryWhileWriting) {
+    DatabaseOptions options;
+    options.walMode = true;
+    options.readConnections = 3;
+    ASSERT_TRUE(processor_->initializeDatabase("gtest_readers_db.db", options));
+    ASSERT_TRUE(processor_->storeBatch("data_processor_logs", std::vector<std::string>(100, "seed")));
+    
+    std::atomic<bool> writing{true};
+    std::atomic<int> badCounts{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (writing) {
+                std::int64_t count = 0;
+                processor_->queryData("SELECT COUNT(*) FROM data_processor_logs WHERE details = ?", {"seed"},
+                    [&count](const QueryRow& row) {
+                        count = row.columnInt(0);
+                        return true;
+                    });
+                if (count != 100) {
+                    badCounts++;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(processor_->storeBatch("data_processor_logs", std::vector<std::string>(20, "ingest")));
+    }
+    writing = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(badCounts.load(), 0);
+    
+    // Statements that write still go through the writer connection
+    EXPECT_TRUE(processor_->queryData("DELETE FROM data_processor_logs WHERE details = 'ingest'", {},
+                                      [](const QueryRow&) { return true; }));
+    auto rows = processor_->queryData("SELECT COUNT(*) FROM data_processor_logs");
+    ASSERT_EQ(rows.size(), 1);
+    EXPECT_EQ(rows[0], "100");
+    
+    // Cleanup
+    processor_.reset();
+    std::remove("gtest_readers_db.db");
+    std::remove("gtest_readers_db.db-wal");
+    std::remove("gtest_readers_db.db-shm");
+}
+
+// 16x12 RGB PNG with four flat quadrants
+static void writeTestPng(const std::string& path) {
+    static const char png[] =
+        "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x10\x00\x00\x00\x0c"
+        "\x08\x02\x00\x00\x00\xe4\x85\xaa\xd6\x00\x00\x00\x1c\x49\x44\x41\x54\x78\xda\x63\x38\x91\x62\x84"
+        "\x15\x89\xe0\x40\x0c\x23\x54\xc3\x2f\xac\x48\x04\x07\x1a\x91\x1a\x00\x21\x1e\x0e\x10\xa2\xf0\x9f"
+        "\x1e\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82";
+    std::ofstream(path, std::ios::binary).write(png, sizeof(png) - 1);
+}
+
+TEST_F(DataProcessorTest, ImageConversionAndThumbnails) {
+    writeTestPng("gtest_image.png");
+    
+    ImageInfo info;
+    ASSERT_TRUE(processor_->processImage("gtest_image.png", info));
+    EXPECT_EQ(info.format, ImageFormat::Png);
+    EXPECT_EQ(info.width, 16);
+    EXPECT_EQ(info.height, 12);
+    EXPECT_EQ(info.channels, 3);
+    
+    EXPECT_TRUE(processor_->convertImageFormat("gtest_image.png", "gtest_image.jpg"));
+    ASSERT_TRUE(processor_->processImage("gtest_image.jpg", info));
+    EXPECT_EQ(info.format, ImageFormat::Jpeg);
+    EXPECT_EQ(info.width, 16);
+    
+    ImageOptions thumb;
+    thumb.maxDimension = 8;
+    auto results = processor_->convertImages({{"gtest_image.jpg", "gtest_thumb.png"},
+                                              {"gtest_image.png", "gtest_thumb.jpg"},
+                                              {"gtest_missing.png", "gtest_never.jpg"}}, thumb);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_TRUE(results[0].ok);
+    EXPECT_EQ(results[0].output.format, ImageFormat::Png);
+    EXPECT_EQ(results[0].output.width, 8);
+    EXPECT_EQ(results[0].output.height, 6);
+    EXPECT_TRUE(results[1].ok);
+    EXPECT_EQ(results[1].output.format, ImageFormat::Jpeg);
+    EXPECT_FALSE(results[2].ok);
+    EXPECT_FALSE(results[2].error.empty());
+    EXPECT_FALSE(std::filesystem::exists("gtest_never.jpg"));
+    
+    // From a worker the batch converts inline; waiting on the pool would deadlock
+    DataProcessorOptions single;
+    single.workerThreads = 1;
+    DataProcessor singleWorker(single);
+    std::vector<ImageResult> nested;
+    auto done = singleWorker.processDataAsync("convert", [&](const std::string&) {
+        nested = singleWorker.convertImages({{"gtest_image.png", "gtest_thumb.jpg"}}, thumb);
+    });
+    ASSERT_EQ(done.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    ASSERT_EQ(nested.size(), 1);
+    EXPECT_TRUE(nested[0].ok);
+    
+    std::ofstream("gtest_not_image.png") << "not an image";
+    EXPECT_FALSE(processor_->processImage("gtest_not_image.png"));
+    
+    for (const char* path : {"gtest_image.png", "gtest_image.jpg", "gtest_thumb.png", "gtest_thumb.jpg",
+                             "gtest_not_image.png"}) {
+        std::remove(path);
+    }
+}
+
+// First TrueType font found in the usual places; DATA_PROCESSOR_TEST_FONT overrides
+static std::string findTestFont() {
+    if (const char* font = std::getenv("DATA_PROCESSOR_TEST_FONT")) {
+        return font;
+    }
+    for (const char* path : {"/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+                             "/usr/share/fonts/TTF/DejaVuSans.ttf",
+                             "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+                             "/System/Library/Fonts/Supplemental/Arial.ttf",
+                             "C:/Windows/Fonts/arial.ttf"}) {
+        if (std::filesystem::exists(path)) {
+            return path;
+        }
+    }
+    return "";
+}
+
+TEST_F(DataProcessorTest, TextShapingAndGlyphsAreCached) {
+    const std::string font = findTestFont();
+    if (font.empty()) {
+        GTEST_SKIP() << "No TrueType font found; set DATA_PROCESSOR_TEST_FONT";
+    }
+    
+    TextLayout first;
+    TextLayout second;
+    ASSERT_TRUE(processor_->processTextLayout("Hello, world", font, TextOptions{}, first));
+    ASSERT_TRUE(processor_->processTextLayout("Hello, world", font, TextOptions{}, second));
+    EXPECT_EQ(first.glyphs, 12u);
+    EXPECT_EQ(first.width, second.width);
+    EXPECT_EQ(first.height, second.height);
+    EXPECT_GT(first.width, 2 * TextOptions{}.padding);
+    
+    ASSERT_TRUE(processor_->renderText("Hello, world", font, "gtest_text.png"));
+    ASSERT_TRUE(processor_->renderText("Hello, world", font, "gtest_text.png"));
+    ImageInfo info;
+    ASSERT_TRUE(processor_->processImage("gtest_text.png", info));
+    EXPECT_EQ(info.width, first.width);
+    EXPECT_EQ(info.height, first.height);
+    EXPECT_EQ(info.channels, 1);
+    
+    // One shape and one rasterization per distinct glyph; repeats hit
+    TextCacheStats stats = processor_->textCacheStats();
+    EXPECT_EQ(stats.faces, 1u);
+    EXPECT_EQ(stats.shapeMisses, 1u);
+    EXPECT_EQ(stats.shapeHits, 3u);
+    EXPECT_GT(stats.glyphHits, stats.glyphMisses);
+    EXPECT_EQ(stats.atlasPages, 1u);
+    
+    EXPECT_FALSE(processor_->renderText("text", "gtest_missing_font.ttf", "gtest_text.png"));
+    DataProcessorOptions options;
+    options.features = Feature::None;
+    DataProcessor minimal(options);
+    EXPECT_FALSE(minimal.renderText("text", font, "gtest_text.png"));
+    std::remove("gtest_text.png");
+}
+
+TEST_F(DataProcessorTest, DownloadFilesReportsEachTransfer) {
+    std::ofstream testFile("gtest_download_src.txt", std::ios::binary);
+    testFile << "Batch download payload";
+    testFile.close();
+    const std::string url = "file://" + std::filesystem::absolute("gtest_download_src.txt").string();
+    
+    std::vector<std::pair<std::string, std::string>> transfers;
+    for (int i = 0; i < 8; ++i) {
+        transfers.emplace_back(url, "gtest_download_" + std::to_string(i) + ".txt");
+    }
+    transfers.emplace_back(url + ".missing", "gtest_download_missing.txt");
+    
+    std::vector<HttpResponse> results = processor_->downloadFiles(transfers);
+    ASSERT_EQ(results.size(), transfers.size());
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(results[i].ok) << results[i].error;
+        std::ifstream downloaded(transfers[i].second, std::ios::binary);
+        std::stringstream content;
+        content << downloaded.rdbuf();
+        EXPECT_EQ(content.str(), "Batch download payload");
+    }
+    EXPECT_FALSE(results.back().ok);
+    
+    // Cleanup
+    std::remove("gtest_download_src.txt");
+    for (const auto& transfer : transfers) {
+        std::remove(transfer.second.c_str());
+    }
+}
+
+TEST_F(DataProcessorTest, DownloadResumesAndSplitsIntoRanges) {
+    std::string data;
+    for (int i = 0; i < 20000; ++i) {
+        data += "ranged download line " + std::to_string(i) + "\n";
+    }
+    std::ofstream source("gtest_ranged_src.txt", std::ios::binary);
+    source << data;
+    source.close();
+    const std::string url = "file://" + std::filesystem::absolute("gtest_ranged_src.txt").string();
+    auto readAll = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    };
+    
+    DownloadOptions segmented;
+    segmented.segments = 4;
+    segmented.minSegmentSize = 64 * 1024;
+    EXPECT_TRUE(processor_->downloadFile(url, "gtest_ranged.txt", segmented));
+    EXPECT_EQ(readAll("gtest_ranged.txt"), data);
+    
+    // Only the missing tail of a partial file is fetched
+    std::ofstream partial("gtest_resumed.txt", std::ios::binary);
+    partial << data.substr(0, data.size() / 3);
+    partial.close();
+    DownloadOptions resume;
+    resume.resume = true;
+    EXPECT_TRUE(processor_->downloadFile(url, "gtest_resumed.txt", resume));
+    EXPECT_EQ(readAll("gtest_resumed.txt"), data);
+    
+    // Cleanup
+    std::remove("gtest_ranged_src.txt");
+    std::remove("gtest_ranged.txt");
+    std::remove("gtest_resumed.txt");
+}
+
 TEST_F(DataProcessorTest, RegexProcessing) {
     std::string text = "Hello world! Email: test@example.com";
     std::string emailPattern = R"([a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,})";
@@ -229,6 +1207,76 @@ TEST_F(DataProcessorTest, InvalidRegexPattern) {
     EXPECT_FALSE(processor_->processTextWithRegex(text, invalidPattern));
 }
 
+TEST_F(DataProcessorTest, ExtractMatchesReturnsOffsets) {
+    std::string text = "ids: 17, 256 and 3";
+    
+    auto matches = processor_->extractMatches(text, R"(\d+)");
+    ASSERT_EQ(matches.size(), 3);
+    EXPECT_EQ(text.substr(matches[0].offset, matches[0].length), "17");
+    EXPECT_EQ(text.substr(matches[1].offset, matches[1].length), "256");
+    EXPECT_EQ(text.substr(matches[2].offset, matches[2].length), "3");
+    
+    auto mixed = processor_->extractMatches(text, std::vector<std::string>{"ids", R"(\d{3})"});
+    ASSERT_EQ(mixed.size(), 2);
+    EXPECT_EQ(mixed[0].patternIndex, 0);
+    EXPECT_EQ(mixed[1].patternIndex, 1);
+    EXPECT_EQ(mixed[1].offset, 9);
+}
+
+TEST_F(DataProcessorTest, RegexCacheEvictsLeastRecentlyUsed) {
+    DataProcessorOptions options;
+    options.regexCacheCapacity = 2;
+    DataProcessor processor(options);
+    
+    processor.processTextWithRegex("abc", "a");
+    processor.processTextWithRegex("abc", "b");
+    processor.processTextWithRegex("abc", "a");
+    processor.processTextWithRegex("abc", "c");
+    
+    RegexCacheStats stats = processor.regexCacheStats();
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 3);
+}
+
+TEST_F(DataProcessorTest, ConvertEncodingFeedsRegexAndJson) {
+    std::string output;
+    EXPECT_TRUE(processor_->convertEncoding("caf\xe9", "ISO-8859-1", "UTF-8", output));
+    EXPECT_EQ(output, "caf\xc3\xa9");
+    EXPECT_TRUE(processor_->convertEncoding("plain", "ISO-8859-1", "UTF-8", output));
+    EXPECT_EQ(output, "plain");
+    EXPECT_FALSE(processor_->convertEncoding("\xff", "UTF-8", "UTF-16LE", output));
+    EXPECT_FALSE(processor_->convertEncoding("x", "NOT-A-CHARSET", "UTF-8", output));
+    
+    EXPECT_TRUE(processor_->processTextWithRegex("caf\xe9 au lait", "caf\xc3\xa9", "ISO-8859-1"));
+    
+    // Big enough to cross read chunks, so code units straddle chunk ends
+    std::string lines;
+    for (int i = 0; i < 50000; ++i) {
+        lines += "{\"name\": \"caf\xc3\xa9\", \"id\": " + std::to_string(i) + "}\n";
+    }
+    std::string wide;
+    ASSERT_TRUE(processor_->convertEncoding(lines, "UTF-8", "UTF-16LE", wide));
+    std::ofstream("gtest_utf16.ndjson", std::ios::binary) << wide;
+    
+    JsonStreamResult result;
+    std::size_t matching = 0;
+    EXPECT_TRUE(processor_->processJsonFile("gtest_utf16.ndjson", {"name"},
+        [&matching](std::size_t, const std::vector<JsonField>& fields) {
+            matching += fields[0].text == "caf\xc3\xa9" ? 1 : 0;
+            return true;
+        }, result, "UTF-16LE"));
+    EXPECT_EQ(result.records, 50000u);
+    EXPECT_EQ(matching, 50000u);
+    
+    ASSERT_TRUE(processor_->convertEncodingFile("gtest_utf16.ndjson", "gtest_utf8.ndjson", "UTF-16LE", "UTF-8"));
+    std::ifstream converted("gtest_utf8.ndjson", std::ios::binary);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(converted), {}), lines);
+    converted.close();
+    std::remove("gtest_utf16.ndjson");
+    std::remove("gtest_utf8.ndjson");
+}
+
 TEST_F(DataProcessorTest, EncryptionWorks) {
     std::string plaintext = "Secret message for GTest";
     std::string key = "mysecretkey1234567890123456789012"; // 32 bytes
@@ -238,6 +1286,27 @@ TEST_F(DataProcessorTest, EncryptionWorks) {
     EXPECT_NE(encrypted, plaintext);
 }
 
+TEST_F(DataProcessorTest, CipherSessionChunksDetectTampering) {
+    CipherSession session(std::string(CipherSession::kKeySize, 'c'));
+    CipherSession::Nonce streamNonce;
+    ASSERT_TRUE(CipherSession::newNonce(streamNonce));
+    
+    std::string chunk = "chunk payload";
+    std::vector<char> sealed(chunk.size() + CipherSession::kTagSize);
+    ASSERT_TRUE(session.sealChunk(streamNonce, 0, true, chunk, sealed.data()));
+    
+    std::string_view sealedView(sealed.data(), sealed.size());
+    std::vector<char> opened(chunk.size());
+    EXPECT_TRUE(session.openChunk(streamNonce, 0, true, sealedView, opened.data()));
+    EXPECT_EQ(std::string(opened.data(), opened.size()), chunk);
+    
+    // Wrong position, missing final marker, or flipped bits all fail
+    EXPECT_FALSE(session.openChunk(streamNonce, 1, true, sealedView, opened.data()));
+    EXPECT_FALSE(session.openChunk(streamNonce, 0, false, sealedView, opened.data()));
+    sealed[0] ^= 1;
+    EXPECT_FALSE(session.openChunk(streamNonce, 0, true, sealedView, opened.data()));
+}
+
 TEST_F(DataProcessorTest, HashGeneration) {
     std::string data = "Test data for hashing in GTest";
     std::string hash = processor_->generateHash(data);
@@ -254,6 +1323,94 @@ TEST_F(DataProcessorTest, HashConsistency) {
     EXPECT_EQ(hash1, hash2);
 }
 
+TEST_F(DataProcessorTest, HashFileMatchesGenerateHash) {
+    std::string data = "File contents for hashing in GTest " + std::string(100000, 'h');
+    std::ofstream testFile("gtest_hash_file.txt", std::ios::binary);
+    testFile << data;
+    testFile.close();
+    
+    EXPECT_EQ(processor_->hashFile("gtest_hash_file.txt"), processor_->generateHash(data));
+    EXPECT_TRUE(processor_->hashFile("gtest_missing_file.txt").empty());
+    
+    // Cleanup
+    std::remove("gtest_hash_file.txt");
+}
+
+TEST_F(DataProcessorTest, SteadyStateCallsDoNotAllocate) {
+    std::string payload(4096, ' ');
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 23);
+    }
+    const std::string key(CipherSession::kKeySize, 'k');
+    const std::string pattern = "q[a-c]+";
+    Sha256Hex hex;
+    std::string compressed, decompressed, encrypted, decrypted;
+    
+    auto pass = [&]() {
+        return processor_->generateHash(payload, hex) &&
+               processor_->compress(payload, compressed) &&
+               processor_->decompress(compressed, decompressed) &&
+               processor_->encryptData(payload, key, encrypted) &&
+               processor_->decryptData(encrypted, key, decrypted) &&
+               !processor_->processTextWithRegex(payload, pattern);
+    };
+    // The first pass sizes the buffers and warms the per-thread contexts
+    ASSERT_TRUE(pass());
+    ASSERT_EQ(decompressed, payload);
+    ASSERT_EQ(decrypted, payload);
+    EXPECT_EQ(std::string(hex.data(), hex.size()), processor_->generateHash(payload));
+    
+    const std::size_t before = threadAllocations;
+    bool ok = true;
+    for (int i = 0; i < 100; ++i) {
+        ok = pass() && ok;
+    }
+    const std::size_t allocations = threadAllocations - before;
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(allocations, 0u);
+    
+    // The rvalue overload takes the buffer instead of copying it
+    std::string owned = payload;
+    std::string asyncHash;
+    processor_->processDataAsync(std::move(owned), [&asyncHash](const std::string& result) {
+        asyncHash = result;
+    }).get();
+    EXPECT_EQ(asyncHash, processor_->generateHash(payload));
+}
+
+TEST_F(DataProcessorTest, MappedBufferIsSharedAcrossPasses) {
+    std::string lines;
+    for (int i = 0; i < 20000; ++i) {
+        lines += "{\"id\": " + std::to_string(i) + ", \"msg\": \"event " + std::to_string(i) + "\"}\n";
+    }
+    std::ofstream("gtest_mapped.ndjson", std::ios::binary) << lines;
+    
+    MappedBuffer mapped("gtest_mapped.ndjson");
+    ASSERT_TRUE(mapped.ok());
+    ASSERT_EQ(mapped.view(), lines);
+    EXPECT_EQ(processor_->hashFile(mapped), processor_->generateHash(lines));
+    EXPECT_TRUE(processor_->processTextWithRegex(mapped.view(), "event 19999"));
+    EXPECT_EQ(processor_->extractMatches(mapped.view(), "event 1234\\b").size(), 1u);
+    JsonStreamResult result;
+    EXPECT_TRUE(processor_->processJsonBatch(mapped.view(), {"id"}, nullptr, result));
+    EXPECT_EQ(result.records, 20000u);
+    
+    CompressionOptions options;
+    options.blockSize = 1 << 16;
+    ASSERT_TRUE(processor_->compressFile(mapped, "gtest_mapped.gz", options));
+    ASSERT_TRUE(processor_->decompressFile("gtest_mapped.gz", "gtest_mapped.out"));
+    EXPECT_EQ(processor_->hashFile("gtest_mapped.out"), processor_->hashFile(mapped));
+    
+    MappedBuffer moved(std::move(mapped));
+    EXPECT_FALSE(mapped.ok());
+    EXPECT_EQ(moved.size(), lines.size());
+    EXPECT_FALSE(MappedBuffer("gtest_missing_file.txt").ok());
+    
+    for (const char* path : {"gtest_mapped.ndjson", "gtest_mapped.gz", "gtest_mapped.out"}) {
+        std::remove(path);
+    }
+}
+
 TEST_F(DataProcessorTest, AsyncProcessing) {
     bool callbackCalled = false;
     std::string result;
@@ -270,6 +1427,30 @@ TEST_F(DataProcessorTest, AsyncProcessing) {
     EXPECT_FALSE(result.empty());
 }
 
+TEST_F(DataProcessorTest, AsyncProcessingReturnsFuture) {
+    std::string result;
+    
+    auto done = processor_->processDataAsync("Future test data", [&result](const std::string& asyncResult) {
+        result = asyncResult;
+    });
+    done.get();
+    
+    EXPECT_EQ(result.length(), 64);
+}
+
+TEST_F(DataProcessorTest, DestructionDrainsAsyncWork) {
+    std::atomic<int> completed{0};
+    
+    for (int i = 0; i < 16; ++i) {
+        processor_->processDataAsync("Drain test " + std::to_string(i), [&completed](const std::string&) {
+            completed++;
+        });
+    }
+    processor_.reset();
+    
+    EXPECT_EQ(completed, 16);
+}
+
 TEST_F(DataProcessorTest, ErrorHandling) {
     EXPECT_FALSE(processor_->hasErrors());
     EXPECT_TRUE(processor_->getLastError().empty());
@@ -329,6 +1510,60 @@ TEST_F(DataProcessorTest, IntegrationTest) {
     EXPECT_FALSE(report.empty());
 }
 
+TEST_F(DataProcessorTest, BatchArchivesAndIndexesTree) {
+    std::filesystem::remove_all("gtest_batch_in");
+    std::filesystem::remove_all("gtest_batch_out");
+    for (int dir = 0; dir < 4; ++dir) {
+        const std::string path = "gtest_batch_in/d" + std::to_string(dir);
+        std::filesystem::create_directories(path);
+        for (int file = 0; file < 25; ++file) {
+            std::ofstream(path + "/f" + std::to_string(file) + ".txt") << std::string(1000 * (file + 1), 'a' + dir);
+        }
+    }
+    DatabaseOptions dbOptions;
+    dbOptions.fileIndex = true;
+    ASSERT_TRUE(processor_->initializeDatabase("gtest_batch.db", dbOptions));
+    
+    CipherSession session(std::string(CipherSession::kKeySize, 'b'));
+    BatchJob job;
+    job.inputDirectory = "gtest_batch_in";
+    job.outputDirectory = "gtest_batch_out";
+    job.session = &session;
+    job.queueCapacity = 4;
+    BatchReport report = processor_->runBatch(job);
+    EXPECT_TRUE(report.ok) << report.firstError;
+    EXPECT_EQ(report.files, 100u);
+    EXPECT_EQ(report.failed, 0u);
+    ASSERT_EQ(report.stages.size(), 6u);
+    for (const BatchStageStats& stage : report.stages) {
+        EXPECT_EQ(stage.items, 100u) << stage.name;
+        EXPECT_LE(stage.maxQueueDepth, job.queueCapacity) << stage.name;
+    }
+    EXPECT_NE(processor_->generateJsonReport().find("\"batch\""), std::string::npos);
+    
+    std::vector<std::string> rows = processor_->queryData(
+        "SELECT hash FROM file_index WHERE path LIKE '%d2/f7.txt'");
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0], processor_->hashFile("gtest_batch_in/d2/f7.txt"));
+    
+    std::ifstream sealedFile("gtest_batch_out/d2/f7.txt.sealed", std::ios::binary);
+    std::string sealed((std::istreambuf_iterator<char>(sealedFile)), {});
+    std::string compressed(sealed.size(), '\0');
+    std::size_t written = 0;
+    ASSERT_TRUE(session.open(sealed, &compressed[0], compressed.size(), written));
+    compressed.resize(written);
+    std::string restored;
+    ASSERT_TRUE(processor_->decompress(compressed, restored));
+    EXPECT_EQ(restored, std::string(8000, 'c'));
+    
+    job.inputDirectory = "gtest_batch_missing";
+    EXPECT_FALSE(processor_->runBatch(job).ok);
+    
+    std::filesystem::remove_all("gtest_batch_in");
+    std::filesystem::remove_all("gtest_batch_out");
+    std::remove("gtest_batch.db");
+}
+
 int main(int argc, char** argv) {
     // Initialize spdlog for tests
     auto logger = spdlog::stdout_color_mt("test_runner");